@@ -0,0 +1 @@
+#include <fcntl.h>
@@ -0,0 +1,106 @@
+//
+//  ORSON/LIB/C/FRAMES. Stacks of base pointers for garbage collectors.
+//
+//  Copyright (C) 2018 James B. Moen.
+//
+//  This  program is free  software: you  can redistribute  it and/or modify it
+//  under the terms of the GNU General Public License as  published by the Free
+//  Software Foundation,  either version 3 of  the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY  WARRANTY; without even  the  implied  warranty  of MERCHANTABILITY  or
+//  FITNESS FOR  A PARTICULAR PURPOSE. See  the GNU General  Public License for
+//  more details.
+//
+//  You  should  have  received  a copy of the GNU General Public License along
+//  with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+//  These functions are used by ORSON/LIB/PRELUDE.OP, and by C code written by
+//  EMIT FRAME PUSH in ORSON/SRC/EMIT.C. Each thread's stack of frames is a run
+//  of virtual memory that's reserved, but not backed by pages, when the stack
+//  is made. Pages are added only when a stack grows into them, so a stack that
+//  is never used deeply costs only one page.
+//
+//  A stack may grow as large as the C stack, whose limit is set by the shell's
+//  command ULIMIT -S. If the C stack has no limit, then the stack may grow to
+//  64 gigabytes. The first pointer in the run is the header, which points to
+//  where the run ends. The stack's BASE follows the header.
+
+//  FRAMES LIMIT. Maximum bytes in a stack if the C stack has no limit.
+
+#define FramesLimit ((size_t) 1 << 36)
+
+//  FRAMES MIN. Minimum bytes in a stack, if we can't reserve more.
+
+#define FramesMin ((size_t) 1 << 20)
+
+//  FRAMES OVER. Report that a stack has overflowed, and halt, much as the OS
+//  would if the C stack overflowed.
+
+void FramesOver(void)
+{ fprintf(stderr, "Stack of frames overflowed.\n");
+  abort(); }
+
+//  MAKE FRAMES. Reserve a new, empty stack and return its BASE. Only the page
+//  with the header is added. The stack's END is initially its BASE, so the
+//  first frame pushed will call GROW FRAMES.
+
+void **MakeFrames(void)
+{ void **header;
+  size_t page = sysconf(_SC_PAGESIZE);
+  struct rlimit limit;
+  size_t size;
+  if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+  { size = limit.rlim_cur < FramesMin ? FramesMin : limit.rlim_cur; }
+  else
+  { size = FramesLimit; }
+  size = (size + page - 1) & ~(page - 1);
+  while (1)
+  { header = mmap(NULL, size, PROT_NONE,
+                  MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (header != MAP_FAILED)
+    { break; }
+    else if (size > FramesMin)
+         { size /= 2; }
+         else
+         { fprintf(stderr, "Can't reserve a stack of frames.\n");
+           abort(); }}
+  if (mprotect(header, page, PROT_READ|PROT_WRITE) != 0)
+  { FramesOver(); }
+  header[0] = (char *) header + size;
+  return header + 1; }
+
+//  GROW FRAMES. TOP has moved past END in the stack that starts at BASE. Add
+//  pages to the stack, doubling its size until TOP is within it, and return
+//  its new END. If the stack can't hold TOP, then we halt.
+
+void **GrowFrames(void **base, void **top, void **end)
+{ char *start = (char *) (base - 1);
+  char *limit;
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t size;
+  if (base == NULL)
+  { FramesOver(); }
+  limit = base[-1];
+  size = ((char *) end - start + page - 1) & ~(page - 1);
+  while (start + size < (char *) top)
+  { size *= 2; }
+  if (start + size > limit)
+  { size = limit - start; }
+  if (start + size < (char *) top
+   || mprotect(start, size, PROT_READ|PROT_WRITE) != 0)
+  { FramesOver(); }
+  return (void **) (start + size); }
+
+//  FREE FRAMES. Release the stack that starts at BASE, and all its pages.
+
+void FreeFrames(void **base)
+{ munmap(base - 1, (char *) base[-1] - (char *) (base - 1)); }
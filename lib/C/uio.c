@@ -0,0 +1 @@
+#include <sys/uio.h>
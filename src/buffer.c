@@ -19,45 +19,79 @@
 
 #include "global.h"
 
-//  INIT BUFFER. Initialize globals.
+//  INIT BUFFER. Initialize globals. Only DEFERRED and TARGET may skip filling
+//  lines, since DEBUG is meant to be read by people.
 
 void initBuffer()
-{ debug  = makeBuffer(stdout, 2);
-  target = makeBuffer(nil, 0); }
+{ debug    = makeBuffer(stdout, 2, true);
+  deferred = makeBuffer(nil, 0, prettying);
+  target   = makeBuffer(nil, 0, prettying); }
 
 //  BUFFER HAS. Test if BUFFER has space on its current line for LENGTH chars.
+//  A BUFFER that doesn't fill lines always has space.
 
 bool bufferHas(refBuffer buffer, int length)
-{ return length < length(buffer) - (end(buffer) - start(buffer)); }
+{ return
+   ! filling(buffer) ||
+   length < length(buffer) - (end(buffer) - line(buffer)); }
+
+//  BUFFER RESERVE. Make sure that BUFFER's block has space for COUNT more
+//  chars after its END. If it doesn't, then grow the block, at least doubling
+//  it.
+
+void bufferReserve(refBuffer buffer, int count)
+{ if (limit(buffer) - end(buffer) < count)
+  { int endOffset = end(buffer) - start(buffer);
+    int lineOffset = line(buffer) - start(buffer);
+    int oldSize = limit(buffer) - start(buffer);
+    int newSize = max(2 * oldSize, endOffset + count);
+    refChar newStart = realloc(start(buffer), newSize);
+    if (newStart == nil)
+    { fail("Cannot grow a buffer to %i bytes in bufferReserve!", newSize); }
+    else
+    { start(buffer) = newStart;
+      end(buffer)   = newStart + endOffset;
+      limit(buffer) = newStart + newSize;
+      line(buffer)  = newStart + lineOffset; }}}
+
+//  BUFFER APPEND. Copy COUNT chars from STRING to the end of BUFFER's block.
+//  We don't fill lines here: that's the caller's job.
+
+void bufferAppend(refBuffer buffer, refChar string, int count)
+{ bufferReserve(buffer, count);
+  memcpy(end(buffer), string, count);
+  end(buffer) += count; }
 
 //  WRITE BLANK. Write a blank to BUFFER, except at the start of a new line.
 
 void writeBlank(refBuffer buffer)
 { if (bufferHas(buffer, 1))
-  { d(end(buffer)) = ' ';
+  { bufferReserve(buffer, 1);
+    d(end(buffer)) = ' ';
     end(buffer) += 1; }
   else
-  { writeBuffer(buffer); }}
+  { writeLine(buffer); }}
 
-//  WRITE BUFFER. Flush BUFFER, writing it to STREAM, followed by a newline.
+//  WRITE BUFFER. End the current line of BUFFER, then flush all its completed
+//  lines to STREAM using a single call to FWRITE. The blanks that indent a new
+//  line stay behind, at the start of the block.
 
 void writeBuffer(refBuffer buffer)
-{ refChar end = end(buffer);
-  refChar start = start(buffer);
-  refStream stream = stream(buffer);
-  if (start < end)
-  { writeBlanks(stream, indent(buffer));
-    while (start < end)
-    { fputc(d(start), stream);
-      start += 1; }
-    fputc(eolChar, stream);
-    end(buffer) = start(buffer); }}
+{ refChar end;
+  int indent = indent(buffer);
+  writeLine(buffer);
+  end = line(buffer) - indent;
+  if (start(buffer) < end)
+  { fwrite(start(buffer), 1, end - start(buffer), stream(buffer));
+    line(buffer) = start(buffer) + indent;
+    end(buffer) = line(buffer); }}
 
 //  WRITE CHAR. Write a nonblank character CH to BUFFER.
 
 void writeChar(refBuffer buffer, char ch)
 { if (! bufferHas(buffer, 1))
-  { writeBuffer(buffer); }
+  { writeLine(buffer); }
+  bufferReserve(buffer, 1);
   d(end(buffer)) = ch;
   end(buffer) += 1; }
 
@@ -68,17 +102,17 @@ void writeChar(refBuffer buffer, char ch)
 void writeCharacter(refBuffer buffer, int ch)
 { if (ch == apostropheChar || ch == backslashChar)
   { if (! bufferHas(buffer, 4))
-    { writeBuffer(buffer); }
+    { writeLine(buffer); }
     writeFormat(buffer, "'\\%c'", ch); }
   else if (isVisibleAsciiChar(ch))
        { if (! bufferHas(buffer, 3))
-         { writeBuffer(buffer); }
+         { writeLine(buffer); }
          writeFormat(buffer, "'%c'", ch); }
        else
        { char digits[hexDigitsPerInt + 1];
          int count = snprintf(digits, hexDigitsPerInt + 1, "%02X", ch);
          if (! bufferHas(buffer, count + 3))
-         { writeBuffer(buffer); }
+         { writeLine(buffer); }
          writeFormat(buffer, "0x%s", digits); }}
 
 //  WRITE CHARS. Write COUNT copies of CH directly to STREAM.
@@ -90,47 +124,36 @@ void writeChars(refStream stream, int count, char ch)
 
 //  WRITE CLEAN NAME. Write STRING to BUFFER as a C name. We assume that STRING
 //  has no "dirty" characters, unacceptable in C names. If BUFFER's line length
-//  is too small for the resulting C name, then write it without line filling.
+//  is too small for the resulting C name, then write it on a line of its own,
+//  without line filling.
 
 void writeCleanName(refBuffer buffer, refChar string)
 { int length = strlen(string);
   if (! bufferHas(buffer, length))
-  { writeBuffer(buffer); }
-  if (length <= length(buffer))
-  { while (d(string) != eosChar)
-    { writeChar(buffer, d(string));
-      string += 1; }}
-  else
-  { refStream stream = stream(buffer);
-    writeBlanks(stream, indent(buffer));
-    while (d(string) != eosChar)
-    { fputc(d(string), stream);
-      string += 1; }
-    fputc(eolChar, stream); }}
+  { writeLine(buffer); }
+  bufferAppend(buffer, string, length);
+  if (filling(buffer) && length > length(buffer))
+  { writeLine(buffer); }}
 
 //  WRITE DIRTY NAME. Write STRING to BUFFER as a C name. It ends with a unique
 //  identifying NUMBER. STRING has one or more "dirty" chars that cannot appear
 //  in C names: they get replaced by "clean" chars that can. If the line length
-//  of BUFFER is too small for the resulting C name, then write it without line
-//  filling.
+//  of BUFFER is too small for the resulting C name, then write it on a line of
+//  its own, without line filling.
 
 void writeDirtyName(refBuffer buffer, refChar string, int number)
 { int count = dirtyLength(string) + intLength(number) + 2;
-  int word;
+  refChar clean;
+  char digits[intLength(number) + strlen(nameDelimiter) + 2];
   if (! bufferHas(buffer, count))
-  { writeBuffer(buffer); }
-  if (count <= length(buffer))
-  { while (d(string) != eosChar)
-    { word = removeChar(r(string));
-      writeFormat(buffer, dirtyToClean(word)); }
-    writeFormat(buffer, "%s%i", nameDelimiter, number); }
-  else
-  { refStream stream = stream(buffer);
-    writeBlanks(stream, indent(buffer));
-    while (d(string) != eosChar)
-    { word = removeChar(r(string));
-      fputs(dirtyToClean(word), stream); }
-    fprintf(stream, "%s%i\n", nameDelimiter, number); }}
+  { writeLine(buffer); }
+  while (d(string) != eosChar)
+  { clean = dirtyToClean(removeChar(r(string)));
+    bufferAppend(buffer, clean, strlen(clean)); }
+  bufferAppend(buffer, digits,
+   sprintf(digits, "%s%i", nameDelimiter, number));
+  if (filling(buffer) && count > length(buffer))
+  { writeLine(buffer); }}
 
 //  WRITE EXACT REAL. Write NUMBER to BUFFER without loss of precision. If it's
 //  possible, we write NUMBER in hexadecimal. Otherwise, we use an awful kludge
@@ -150,7 +173,7 @@ void writeExactReal(refBuffer buffer, double number)
     writeChar(buffer, '*');
     writeChar(buffer, ')');
     if (! bufferHas(buffer, 4 * sizeof(double) + 2))
-    { writeBuffer(buffer); }
+    { writeLine(buffer); }
     writeChar(buffer, doubleChar);
     for (count = 1; count <= sizeof(double); count += 1)
     { writeFormat(buffer, "\\x%02X", 0xFF & d(start));
@@ -163,14 +186,14 @@ void writeExactReal(refBuffer buffer, double number)
 void writeFormat(refBuffer buffer, refChar format, ...)
 { vaList arguments;
   int length;
-  char string[length(buffer)];
+  char string[maxBufferLength + 1];
   vaStart(arguments, format);
-  length = vsnprintf(string, length(buffer), format, arguments);
+  length = vsnprintf(string, maxBufferLength + 1, format, arguments);
   vaEnd(arguments);
+  length = min(length, maxBufferLength);
   if (! bufferHas(buffer, length))
-  { writeBuffer(buffer); }
-  strcpy(end(buffer), string);
-  end(buffer) += length; }
+  { writeLine(buffer); }
+  bufferAppend(buffer, string, length); }
 
 //  WRITE HERALD. Write a comment to STREAM that tells the compiler's name, its
 //  version, the current date, and the current time. Depending on the date, and
@@ -185,6 +208,19 @@ void writeHerald(refStream stream)
   strftime(when, 46, "%A, %B %d, %Y at %I:%M %p %Z", localtime(r(count)));
   fprintf(stream, "/* Created by %s %s on %s. */\n", me, version, when); }
 
+//  WRITE LINE. End the current line of BUFFER, if it has any chars, and start
+//  a new one, indented by blanks. Unlike WRITE BUFFER, we don't flush BUFFER.
+
+void writeLine(refBuffer buffer)
+{ int indent = indent(buffer);
+  if (end(buffer) > line(buffer))
+  { bufferReserve(buffer, indent + 1);
+    d(end(buffer)) = eolChar;
+    end(buffer) += 1;
+    memset(end(buffer), ' ', indent);
+    end(buffer) += indent;
+    line(buffer) = end(buffer); }}
+
 //  WRITE NAKED STRING. Write STRING to BUFFER, without surrounding quote marks
 //  or internal escapes. We assume STRING will fit on one line.
 
@@ -192,26 +228,17 @@ void writeNakedString(refBuffer buffer, refString string)
 { int length = bytes(string);
   refSnip snip = first(string);
 
-//  WRITE SNIP. Write the first COUNT chars in SNIP.
-
-  void writeSnip(refSnip snip, int count)
-  { refChar start = self(snip);
-    while (count > 0)
-    { writeChar(buffer, d(start));
-      count -= 1;
-      start += 1; }}
-
-//  Make sure there's enough space on the current line for STRING. Traverse all
-//  but the last SNIP in STRING. Finally, traverse the last SNIP.
+//  Make sure there's enough space on the current line for STRING. Copy all but
+//  the last SNIP in STRING. Finally, copy the last SNIP.
 
   if (! bufferHas(buffer, length))
-  { writeBuffer(buffer); }
+  { writeLine(buffer); }
   while (length > maxSnipLength)
-  { writeSnip(snip, maxSnipLength);
+  { bufferAppend(buffer, self(snip), maxSnipLength);
     length -= maxSnipLength;
     snip = next(snip); }
   if (length > 0)
-  { writeSnip(snip, length); }}
+  { bufferAppend(buffer, self(snip), length); }}
 
 //  WRITE NAME. Write NAME to BUFFER as a C name. NO NAME is always followed by
 //  a different identifying number.
@@ -238,7 +265,7 @@ void writeQuotedString(refBuffer buffer, refString string)
   void writeBreak(int length)
   { if (! bufferHas(buffer, length))
     { writeChar(buffer, doubleChar);
-      writeBuffer(buffer);
+      writeLine(buffer);
       writeChar(buffer, doubleChar); }}
 
 //  WRITE SLASHED CHAR. Write the char CH with an /X escape followed by exactly
@@ -286,7 +313,7 @@ void writeQuotedString(refBuffer buffer, refString string)
 //  visit all but the last SNIP in string. Finally visit the last SNIP.
 
   if (! bufferHas(buffer, 3))
-  { writeBuffer(buffer); }
+  { writeLine(buffer); }
   writeChar(buffer, doubleChar);
   while (length > maxSnipLength)
   { writeSnip(snip, maxSnipLength);
@@ -0,0 +1,159 @@
+//
+//  ORSON/COST. Measure what it costs to transform PROCs.
+//
+//  Copyright (C) 2012 James B. Moen.
+//
+//  This program  is free  software: you can  redistribute it and/or  modify it
+//  under the terms of the  GNU General Public License as published by the Free
+//  Software Foundation, either  version 3 of the License,  or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY  WARRANTY; without  even  the implied  warranty  of MERCHANTABILITY  or
+//  FITNESS FOR A  PARTICULAR PURPOSE.  See the GNU  General Public License for
+//  more details.
+//
+//  You should  have received a  copy of the  GNU General Public  License along
+//  with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "global.h"
+
+//  If the -c option is given, then UPDATE PROCEDURES measures the cost of each
+//  PROC body it transforms. The body's character count tells where it appears
+//  in a source file, so PROCs made by calling the same form many times share a
+//  COST. A PROC's cost doesn't include the costs of PROCs that are transformed
+//  while it is, because those are charged to PROCs of their own. CHARGED holds
+//  the total costs of all PROCs measured so far. We subtract it from a running
+//  total to get what hasn't been charged yet.
+
+//  INIT COST. Initialize globals.
+
+void initCost()
+{ int index;
+  bytes(r(charged))      = 0;
+  duration(r(charged))   = 0.0;
+  transforms(r(charged)) = 0;
+  for (index = 0; index < costsLength; index += 1)
+  { costs[index] = nil; }
+  hunkBytes      = 0;
+  transformCount = 0; }
+
+//  PROCESSOR TIME. Return how many seconds of processor time we've used.
+
+double processorTime()
+{ return (double) clock() / CLOCKS_PER_SEC; }
+
+//  START COST. Start measuring the cost of a PROC. Record in METER how much of
+//  each running total hasn't been charged yet.
+
+void startCost(refCost meter)
+{ bytes(meter)      = hunkBytes - bytes(r(charged));
+  duration(meter)   = processorTime() - duration(r(charged));
+  transforms(meter) = transformCount - transforms(r(charged)); }
+
+//  STOP COST. Stop measuring the cost of a PROC whose body has the character
+//  count COUNT. We measured it using METER. Charge the cost to the PROC's COST
+//  in COSTS, and make that COST if it doesn't exist yet.
+
+void stopCost(refCost meter, int count)
+{ long    bytes;
+  double  duration;
+  int     index;
+  refCost next;
+  long    transforms;
+
+//  Find how much was spent since START COST, that wasn't charged to some other
+//  PROC. Charge it to this PROC.
+
+  bytes      = hunkBytes - bytes(r(charged)) - bytes(meter);
+  duration   = processorTime() - duration(r(charged)) - duration(meter);
+  transforms = transformCount - transforms(r(charged)) - transforms(meter);
+  bytes(r(charged))      += bytes;
+  duration(r(charged))   += duration;
+  transforms(r(charged)) += transforms;
+
+//  Find the COST for COUNT in its bucket. If there isn't one, then make it.
+
+  index = (unsigned int) count % costsLength;
+  next = costs[index];
+  while (next != nil && count(next) != count)
+  { next = next(next); }
+  if (next == nil)
+  { next = makeCost(count);
+    next(next) = costs[index];
+    costs[index] = next; }
+
+//  Add to the COST.
+
+  bytes(next)      += bytes;
+  duration(next)   += duration;
+  procs(next)      += 1;
+  transforms(next) += transforms; }
+
+//  WRITE COSTS. Write the MAX COST COUNT most expensive COSTs to DEBUG, most
+//  expensive first, followed by the total for all of them.
+
+void writeCosts()
+{ int     count;
+  int     index;
+  refCost next;
+  int     procs;
+  refCost *sorted;
+
+//  IS COSTLIER. Compare the COSTs that LEFT and RIGHT point to, so that QSORT
+//  will put the most expensive one first.
+
+  int isCostlier(const void *left, const void *right)
+  { double leftDuration = duration(d((refCost *) left));
+    double rightDuration = duration(d((refCost *) right));
+    return (leftDuration < rightDuration) - (leftDuration > rightDuration); }
+
+//  WRITE PLACE. Write the path and line number of the source file char whose
+//  character count is COUNT.
+
+  void writePlace(int count)
+  { int     line;
+    refChar path;
+    line = findLine(r(path), count);
+    if (path == nil)
+    { fprintf(stream(debug), "?\n"); }
+    else
+    { fprintf(stream(debug), "%s:%i\n", path, line); }}
+
+//  Lost? This is WRITE COSTS's body. Copy all the COSTs into SORTED, then sort
+//  them so the most expensive ones come first.
+
+  count = 0;
+  for (index = 0; index < costsLength; index += 1)
+  { next = costs[index];
+    while (next != nil)
+    { count += 1;
+      next = next(next); }}
+  sorted = malloc(count * sizeof(refCost) + 1);
+  if (sorted == nil)
+  { fail("Cannot sort costs in writeCosts!"); }
+  count = 0;
+  procs = 0;
+  for (index = 0; index < costsLength; index += 1)
+  { next = costs[index];
+    while (next != nil)
+    { sorted[count] = next;
+      count += 1;
+      procs += procs(next);
+      next = next(next); }}
+  qsort(sorted, count, sizeof(refCost), isCostlier);
+
+//  Write the most expensive COSTs, then the totals.
+
+  fprintf(stream(debug), "%10s %7s %10s %12s  %s\n",
+   "msec", "procs", "transforms", "bytes", "place");
+  for (index = 0; index < count && index < maxCostCount; index += 1)
+  { next = sorted[index];
+    fprintf(stream(debug), "%10.3f %7i %10li %12li  ",
+     duration(next) * 1000.0, procs(next), transforms(next), bytes(next));
+    writePlace(count(next)); }
+  fprintf(stream(debug), "%10.3f %7i %10li %12li  %s\n",
+   duration(r(charged)) * 1000.0, procs, transforms(r(charged)),
+   bytes(r(charged)), "total");
+  free(sorted); }
@@ -115,7 +115,7 @@ void writeMatches(refMatch matches)
 //  WRITE MATCH. Write a MATCH to STDOUT.
 
 void writeMatch(refMatch match)
-{ refBuffer buffer = makeBuffer(stdout, 0);
+{ refBuffer buffer = makeBuffer(stdout, 0, true);
   writeFormat(buffer, "[Match");
   writeBlank(buffer);
   writingObject(buffer, leftLayer(match));
@@ -127,6 +127,7 @@ void writeMatch(refMatch match)
   writingObject(buffer, rightType(match));
   writeChar(buffer, ']');
   writeBuffer(buffer);
+  free(start(buffer));
   free(buffer); }
 
 //  WRITE NAMES. Write the name table NAMES to STREAM.
@@ -26,12 +26,25 @@
 //  INIT EMIT. Initialize globals.
 
 void initEmit()
-{ countName  = makeStub(internCleanName("count"));
-  frameName  = internCleanName("frame");
-  initCount  = 0;
-  linkName   = makeStub(internCleanName("link"));
-  resultName = makeStub(internCleanName("result"));
-  topName    = internSecretName("FrameTop"); }
+{ definitions     = pushLayer(nil, plainInfo);
+  emitTime        = 0.0;
+  endName         = internSecretName("FrameEnd");
+  firstDefinition = nil;
+  frameName       = internCleanName("frame");
+  initCount       = 0;
+  lastDefinition  = nil;
+  resultName      = makeStub(internCleanName("result"));
+  threadNames     = nil;
+  topName         = internSecretName("FrameTop");
+
+//  Make a list of the prelude's variables that are local to each thread.
+
+  threadNames = makePair(internSecretName("Exception"), threadNames);
+  threadNames = makePair(internSecretName("FrameBase"), threadNames);
+  threadNames = makePair(endName, threadNames);
+  threadNames = makePair(topName, threadNames);
+  threadNames = makePair(internSecretName("LabelTop"), threadNames);
+  threadNames = makePair(internSecretName("Thrown"), threadNames); }
 
 //  EMIT ASSIGNMENT. Write C code which sets a variable NAME to the value of an
 //  expression TERM.
@@ -56,8 +69,10 @@ void emitFrameAssignment(refObject frame, refObject name, refObject term)
   writeChar(target, ';'); }
 
 //  EMIT FRAME DECLARATION. Write C code which declares certain names in a list
-//  of equates TERMS as slots in the C STRUCT called FRAME. These names must be
-//  marked by the garbage collector. None are bound to PROCs.
+//  of equates TERMS as slots in a C STRUCT. These names must be marked by the
+//  garbage collector. None are bound to PROCs. FRAME is a pointer to the
+//  STRUCT, which will be a block of slots on the FRAMEs stack. All these names
+//  have REF types, so each one takes exactly one slot.
 
 void emitFrameDeclaration(refObject frame, refObject terms)
 { refObject name;
@@ -65,8 +80,6 @@ void emitFrameDeclaration(refObject frame, refObject terms)
   refObject value;
   writeFormat(target, "struct");
   writeChar(target, '{');
-  emitVariableDeclaration(rowVoidExternal, linkName);
-  emitVariableDeclaration(int2Simple, countName);
   while (terms != nil && cdr(terms) != nil)
   { type  = car(terms); terms = cdr(terms);
     name  = car(terms); terms = cdr(terms);
@@ -74,6 +87,7 @@ void emitFrameDeclaration(refObject frame, refObject terms)
     if (value != nil && ! isProcEquate(type, value) && isMarkable(type))
     { emitVariableDeclaration(type, name); }}
   writeChar(target, '}');
+  writeChar(target, '*');
   writeName(target, frame);
   writeChar(target, ';'); }
 
@@ -92,14 +106,18 @@ void emitFrameInitialization(refObject frame, refObject terms)
     if (value != nil && ! isProcEquate(type, value) && isMarkable(type))
     { emitFrameAssignment(frame, name, hooks[nilHook]); }}}
 
-//  EMIT FRAME NAME. Write C code that accesses NAME, a slot in FRAME.
+//  EMIT FRAME NAME. Write C code that accesses NAME, a slot in FRAME. If FRAME
+//  is NIL, then ELIDE FRAMES removed it, and NAME is an ordinary variable.
 
 void emitFrameName(refObject frame, refObject name)
-{ writeName(target, frame);
-  writeChar(target, '.');
+{ if (frame != nil)
+  { writeName(target, frame);
+    writeChar(target, '-');
+    writeChar(target, '>'); }
   writeName(target, name); }
 
-//  EMIT FRAME POP. Write C code that pops the current frame, named FRAME.
+//  EMIT FRAME POP. Write C code that pops the current frame, named FRAME, by
+//  moving TOP back to where FRAME starts.
 
 void emitFramePop(refObject frame)
 { writeName(target, topName);
@@ -107,18 +125,20 @@ void emitFramePop(refObject frame)
   writeChar(target, '=');
   writeBlank(target);
   writeName(target, frame);
-  writeChar(target, '.');
-  writeName(target, linkName);
   writeChar(target, ';'); }
 
-//  EMIT FRAME PUSH. Write C code that pushes a frame named FRAME. It has COUNT
-//  slots.
-
-void emitFramePush(refObject frame, int count)
+//  EMIT FRAME PUSH. Write C code that pushes a frame named FRAME. We set FRAME
+//  to TOP, then move TOP past FRAME's slots. If TOP is now past END, then the
+//  stack of frames needs more pages. We call GROW FRAMES, which is defined in
+//  ORSON/LIB/C/FRAMES.C, to add them and move END. That rarely happens.
 
-//  Write C code that sets FRAME's LINK slot to TOP, then sets TOP to FRAME.
-
-{ emitFrameAssignment(frame, linkName, topName);
+void emitFramePush(refObject frame)
+{ writeName(target, frame);
+  writeBlank(target);
+  writeChar(target, '=');
+  writeBlank(target);
+  writeName(target, topName);
+  writeChar(target, ';');
   writeName(target, topName);
   writeBlank(target);
   writeChar(target, '=');
@@ -126,46 +146,93 @@ void emitFramePush(refObject frame, int count)
   writeChar(target, '(');
   emitCastDeclaration(rowVoidExternal);
   writeChar(target, ')');
-  writeChar(target, '&');
   writeBlank(target);
+  writeChar(target, '(');
   writeName(target, frame);
-  writeChar(target, ';');
-
-//  Write C code that sets FRAME's COUNT slot to COUNT.
-
-  emitFrameName(frame, countName);
   writeBlank(target);
-  writeChar(target, '=');
+  writeChar(target, '+');
   writeBlank(target);
-  writeFormat(target, "%i", count);
+  writeChar(target, '1');
+  writeChar(target, ')');
+  writeChar(target, ';');
+  writeFormat(target, "if");
+  writeChar(target, '(');
+  writeFormat(target, "__builtin_expect");
+  writeChar(target, '(');
+  writeName(target, topName);
+  writeChar(target, '>');
+  writeName(target, endName);
+  writeChar(target, ',');
+  writeChar(target, '0');
+  writeChar(target, ')');
+  writeChar(target, ')');
+  writeName(target, endName);
+  writeChar(target, '=');
+  writeFormat(target, "GrowFrames");
+  writeChar(target, '(');
+  writeName(target, baseName);
+  writeChar(target, ',');
+  writeName(target, topName);
+  writeChar(target, ',');
+  writeName(target, endName);
+  writeChar(target, ')');
   writeChar(target, ';'); }
 
-//  EMIT FUNCTION DEFINITIONS. If any equates in a list TERMS define PROCs then
-//  write C code that defines them as C functions. We first write declarations,
-//  so they can call each other freely, then write definitions. If FLAG is TRUE
-//  then we prefix the declarations by AUTO.
-
-void emitFunctionDefinitions(bool flag, refObject terms)
+//  EMIT FUNCTION ATTRIBUTES. Write GCC attributes for the C function made from
+//  the PROC closure TERM, using what we know about its body. If the body
+//  always causes an exception, then the function never returns, and calls to
+//  it are unlikely. If the body has no side effects, and the PROC returns a
+//  value, then the function is pure, so GCC may remove or combine calls to it.
+
+void emitFunctionAttributes(refObject term)
+{ refObject body = car(cadddr(term));
+  if (isExceptional(body))
+  { writeFormat(target, "__attribute__((cold,noreturn))");
+    writeBlank(target); }
+  else if (! isGroundSubtype(caddr(cadr(term)), voidSimple)
+        && ! isEffected(body))
+       { writeFormat(target, "__attribute__((pure))");
+         writeBlank(target); }}
+
+//  EMIT FUNCTION DECLARATIONS. If any equates in a list TERMS define PROCs
+//  then write C code that declares them as C functions, so they can call each
+//  other freely. If FLAG is TRUE then we prefix the declarations by AUTO.
+//  Otherwise they're global, so we prefix them by STATIC and by their
+//  attributes, which their definitions inherit.
+
+void emitFunctionDeclarations(bool flag, refObject terms)
 { refObject name;
-  refObject temp;
   refObject type;
   refObject value;
-  temp = terms;
-  while (temp != nil && cdr(temp) != nil)
-  { type  = car(temp); temp = cdr(temp);
-    name  = car(temp); temp = cdr(temp);
-    value = car(temp); temp = cdr(temp);
+  while (terms != nil && cdr(terms) != nil)
+  { type  = car(terms); terms = cdr(terms);
+    name  = car(terms); terms = cdr(terms);
+    value = car(terms); terms = cdr(terms);
     if (value != nil && isProcEquate(type, value))
     { if (flag)
       { writeFormat(target, "auto");
         writeBlank(target); }
+      else
+      { writeFormat(target, "static");
+        writeBlank(target);
+        emitFunctionAttributes(value); }
       emitFunctionDeclaration(cadr(value), name);
-      writeChar(target, ';'); }}
-  temp = terms;
-  while (temp != nil && cdr(temp) != nil)
-  { type  = car(temp); temp = cdr(temp);
-    name  = car(temp); temp = cdr(temp);
-    value = car(temp); temp = cdr(temp);
+      writeChar(target, ';'); }}}
+
+//  EMIT FUNCTION DEFINITIONS. If any equates in a list TERMS define PROCs then
+//  write C code that defines them as C functions. We first write declarations,
+//  then write definitions. If FLAG is TRUE then we prefix the declarations by
+//  AUTO.
+
+void emitFunctionDefinitions(bool flag, refObject terms)
+{ refObject name;
+  refObject type;
+  refObject value;
+  emitFunctionDeclarations(flag, terms);
+  while (terms != nil && cdr(terms) != nil)
+  { type  = car(terms); terms = cdr(terms);
+    name  = car(terms); terms = cdr(terms);
+    value = car(terms); terms = cdr(terms);
     if (value != nil && isProcEquate(type, value))
     { emitFunctionDefinition(name, value); }}}
 
@@ -191,6 +258,30 @@ void emitFunctionDefinition(refObject name, refObject term)
     writeChar(target, ';'); }
   writeChar(target, '}'); }
 
+//  EMIT IF TEST. Write C code for the test of an IF clause. TERMS is the rest
+//  of the IF term, starting with the test. If the test's clause always causes
+//  an exception, then we tell GCC the test is probably false. If it's the last
+//  test, and its ELSE clause always causes an exception, then we tell GCC that
+//  it's probably true.
+
+void emitIfTest(refObject terms)
+{ if (isExceptional(cadr(terms)))
+  { writeFormat(target, "__builtin_expect");
+    writeChar(target, '(');
+    emitExpression(car(terms), 13);
+    writeChar(target, ',');
+    writeChar(target, '0');
+    writeChar(target, ')'); }
+  else if (cdddr(terms) == nil && isExceptional(caddr(terms)))
+       { writeFormat(target, "__builtin_expect");
+         writeChar(target, '(');
+         emitExpression(car(terms), 13);
+         writeChar(target, ',');
+         writeChar(target, '1');
+         writeChar(target, ')'); }
+       else
+       { emitExpression(car(terms), 13); }}
+
 //  EMIT INITIALIZER DECLARATION. Write the declaration for a C function, whose
 //  name is derived from INIT COUNT. It initializes global variables.
 
@@ -218,9 +309,11 @@ void emitLabels(refObject terms)
 
 //  EMIT VARIABLE DECLARATIONS. Write C code that declares some names in a list
 //  of equates TERMS as variables. None of these names are bound to PROCs. They
-//  need not be marked by the garbage collector.
+//  need not be marked by the garbage collector, unless FRAME is NIL. If we're
+//  THREADING, then names in THREAD NAMES get a separate variable in each
+//  thread.
 
-void emitVariableDeclarations(refObject terms)
+void emitVariableDeclarations(refObject frame, refObject terms)
 { refObject name;
   refObject type;
   refObject value;
@@ -228,12 +321,16 @@ void emitVariableDeclarations(refObject terms)
   { type  = car(terms); terms = cdr(terms);
     name  = car(terms); terms = cdr(terms);
     value = car(terms); terms = cdr(terms);
-    if (value == nil || (! isProcEquate(type, value) && ! isMarkable(type)))
-    { emitVariableDeclaration(type, name); }}}
+    if (value == nil
+     || (! isProcEquate(type, value) && (frame == nil || ! isMarkable(type))))
+    { if (threading && isMember(name, threadNames))
+      { writeFormat(target, "__thread "); }
+      emitVariableDeclaration(type, name); }}}
 
 //  EMIT VARIABLE DEFINITIONS. Initialize C variables in list of equates TERMS.
-//  Those that have markable types are slots in FRAME. We don't initialize them
-//  to Orson's NIL, because EMIT FRAME INITIALIZATION will have done that.
+//  Those that have markable types are slots in FRAME, if FRAME isn't NIL. We
+//  don't initialize them to Orson's NIL, because EMIT FRAME INITIALIZATION
+//  will have done that.
 
 void emitVariableDefinitions(refObject frame, refObject terms)
 { refObject name;
@@ -244,26 +341,12 @@ void emitVariableDefinitions(refObject frame, refObject terms)
     name  = car(terms); terms = cdr(terms);
     value = car(terms); terms = cdr(terms);
     if (value != nil && ! isProcEquate(type, value))
-    { if (isMarkable(type))
+    { if (frame != nil && isMarkable(type))
       { if (! isNil(value))
         { emitFrameAssignment(frame, name, value); }}
       else
       { emitAssignment(name, value); }}}}
 
-//  FRAME LENGTH. Return the number of names in the list of equates TERMS which
-//  are not bound to PROCs and must be bound by the garbage collector.
-
-int frameLength(refObject terms)
-{ int count = 0;
-  refObject type;
-  refObject value;
-  while (terms != nil && cdr(terms) != nil)
-  { type  = car(terms); terms = cddr(terms);
-    value = car(terms); terms = cdr(terms);
-    if (value != nil && ! isProcEquate(type, value) && isMarkable(type))
-    { count += 1; }}
-  return count; }
-
 //  HAS VARIABLES. Test if some equate in the list TERMS will become a variable
 //  declaration in C.
 
@@ -40,9 +40,11 @@ void initError()
 
 //  Variables that attribute errors to source file positions. (See ORSON/FILE.)
 
-  allErrs   = setEmpty();
-  charCount = 0;
-  places    = nil;
+  allErrs      = setEmpty();
+  charCount    = 0;
+  places       = nil;
+  placesLength = 0;
+  placesLimit  = 0;
 
 //  Associate ERRs with their MNEMONICs and MESSAGES, in lexicographic order of
 //  MNEMONICs. MNEMONICs must be in ASCII (see ORSON/CHAR).
@@ -136,29 +138,26 @@ void initError()
   makeErr("zix",  zeroInjErr,        "Zero 'inj' expression expected."); }
 
 //  INSERT ERR.  Assert that the error ERR was found at character number COUNT.
-//  We add ERR to ALL ERRS, then add COUNT and ERR to a PLACE in PLACES, making
-//  sure that PLACES is sorted in increasing order of COUNTs.  FIRST PLACE is a
-//  temporary head node that simplifies insertion.
+//  We add ERR to ALL ERRS, then add COUNT and ERR to a PLACE at the end of the
+//  array PLACES. Broken programs can have thousands of errors, so we don't
+//  sort PLACES here: WRITE ERROR LINES sorts it once instead. Errors often
+//  come in bunches at the same COUNT, so we add them to the last PLACE if we
+//  can. We double the size of PLACES when it runs out of room.
 
 void insertErr(int count, int err)
-{ place firstPlace;
-  refPlace leftPlace = r(firstPlace);
-  refPlace rightPlace = places;
-  firstPlace.next = places;
-  while (true)
-  { if (rightPlace == nil)
-    { next(leftPlace) = makePlace(count, err, nil);
-      break; }
-    else if (count(rightPlace) == count)
-         { errs(rightPlace) = setAdjoin(errs(rightPlace), err);
-           break; }
-         else if (count(rightPlace) > count)
-              { next(leftPlace) = makePlace(count, err, rightPlace);
-                break; }
-              else
-              { leftPlace = rightPlace;
-                rightPlace = next(rightPlace); }}
-  places = firstPlace.next;
+{ refPlace lastPlace = places + placesLength - 1;
+  if (placesLength > 0 && count(lastPlace) == count)
+  { errs(lastPlace) = setAdjoin(errs(lastPlace), err); }
+  else
+  { if (placesLength == placesLimit)
+    { placesLimit = max(2 * placesLimit, 64);
+      places = realloc(places, placesLimit * placeSize);
+      if (places == nil)
+      { fail("Cannot make a lastPlace for %i in insertErr!", count); }}
+    lastPlace = places + placesLength;
+    count(lastPlace) = count;
+    errs(lastPlace)  = makeSet(err);
+    placesLength += 1; }
   allErrs = setAdjoin(allErrs, err); }
 
 //  OBJECT ERROR. Assert that ERR occurred while we did something to OBJECT. It
@@ -180,33 +179,141 @@ void objectError(refObject object, int err)
 void sourceError(int err)
 { insertErr(charCount, err); }
 
-//  GET ERRS. Return the set of ERRs from the character count COUNT. If the set
-//  isn't empty, then it's in the first PLACE in PLACES, which gets deleted. We
-//  need not FREE it because Orson will halt soon anyway.
-
-set getErrs(int count)
-{ if (places != nil && count(places) == count)
-  { set errs = errs(places);
-    places = next(places);
-    return errs; }
-  else
-  { return setEmpty(); }}
-
-//  WRITE ERROR LINES. Write a summary of the errors in all source files.
+//  WRITE ERROR LINES. Write a summary of the errors in all source files. If -j
+//  was given on the command line, then write a JSON object for each error.
 
 void writeErrorLines()
-{ int       ch;                   //  Most recent char from SOURCE.
-  set       errs[maxErrsLength];  //  The set of ERRs at each index of LINE.
+{ set       errs[maxErrsLength];  //  The set of ERRs at each index of LINE.
   refSet    errsEnd;              //  End of ERRS.
-  refFile   file;                 //  A revisited FILE.
+  refSet    errsStart;            //  A tail of ERRS.
+  refFile   file;                 //  The FILE where errors occurred.
   int       line[maxLineLength];  //  Most recent line from SOURCE.
   refInt    lineEnd;              //  End of LINE.
-  int       lineNumber;           //  Count lines read from SOURCE.
+  int       lineNumber;           //  The number of LINE in SOURCE.
+  refSpot   lineSpot;             //  Where LINE starts in SOURCE.
   refInt    lineStart;            //  A tail of LINE.
   refChar   newline;              //  A newline or "".
+  refPlace  nextPlace;            //  The next PLACE to write.
+  refPlace  placesEnd;            //  End of PLACES.
   refStream source;               //  Connected to an Orson source program.
+  int       start;                //  Character count where FILE starts.
   bool      titled;               //  Have we written a title?
 
+//  IS EARLIER. Compare the PLACEs that LEFT and RIGHT point to, so that QSORT
+//  will put the one with the smaller COUNT first.
+
+  int isEarlier(const void *left, const void *right)
+  { int leftCount = count((refPlace) left);
+    int rightCount = count((refPlace) right);
+    return (leftCount > rightCount) - (leftCount < rightCount); }
+
+//  SORT PLACES. Sort PLACES in increasing order of their COUNTs, then merge
+//  PLACEs with equal COUNTs.
+
+  void sortPlaces()
+  { refPlace left;
+    refPlace right;
+    if (placesLength > 1)
+    { qsort(places, placesLength, placeSize, isEarlier);
+      left = places;
+      right = places + 1;
+      while (right < places + placesLength)
+      { if (count(left) == count(right))
+        { errs(left) = setUnion(errs(left), errs(right)); }
+        else
+        { left += 1;
+          d(left) = d(right); }
+        right += 1; }
+      placesLength = left - places + 1; }}
+
+//  FIND FILE. Set FILE to the FILE for the source file where the error at NEXT
+//  PLACE occurred, and START to the char count where that file starts. If it's
+//  the FILE we found last time, then we need not search for it. If we're not
+//  writing JSON, then we close the last FILE's SOURCE, and open this one's.
+
+  void findFile()
+  { start = (count(nextPlace) >> charIndexBits) << charIndexBits;
+    if (file == nil || count(file) != start)
+    { if (source != nil && fclose(source) != 0)
+      { fail("Cannot close '%s' in writeErrors!", path(file)); }
+      file = next(firstFile);
+      while (file != nil && count(file) != start)
+      { file = next(file); }
+      if (file == nil || length(file) == 0)
+      { fail("Errors remain unresolved in writeErrors!"); }
+      titled = false;
+      if (! jsoning)
+      { source = fopen(path(file), "r");
+        if (source == nil)
+        { fail("Cannot open '%s' in writeErrors!", path(file)); }}}}
+
+//  FIND SPOT. Set LINE SPOT to the SPOT of the line in FILE where the error at
+//  NEXT PLACE occurred, and LINE NUMBER to that line's number. A line's chars
+//  have the counts after its SPOT's COUNT, up to and including the next SPOT's
+//  COUNT, so we can use a binary search.
+
+  void findSpot()
+  { int high = length(file) - 1;
+    int low = 0;
+    int mid;
+    if (count(nextPlace) <= count(spots(file)))
+    { fail("Errors remain unresolved in writeErrors!"); }
+    while (low < high)
+    { mid = (low + high + 1) / 2;
+      if (count(spots(file) + mid) < count(nextPlace))
+      { low = mid; }
+      else
+      { high = mid - 1; }}
+    lineSpot = spots(file) + low;
+    lineNumber = low + 1; }
+
+//  IS IN LINE. Test if the error at NEXT PLACE occurred in the line whose SPOT
+//  is LINE SPOT.
+
+  bool isInLine()
+  { if (nextPlace >= placesEnd)
+    { return false; }
+    else if (lineSpot + 1 < spots(file) + length(file))
+         { return count(nextPlace) <= count(lineSpot + 1); }
+         else
+         { return count(nextPlace) < start + (1 << charIndexBits); }}
+
+//  WRITE JSON STRING. Write STRING as a JSON string constant. We write grave
+//  accents as quotation marks, as WRITE ERROR MESSAGES does.
+
+  void writeJsonString(refChar string)
+  { fputc(doubleChar, stdout);
+    while (d(string) != eosChar)
+    { if (d(string) == accentChar || d(string) == doubleChar)
+      { fputs("\\\"", stdout); }
+      else if (d(string) == backslashChar)
+           { fputs("\\\\", stdout); }
+           else if ((d(string) & 0xFF) < ' ')
+                { fprintf(stdout, "\\u%04X", d(string)); }
+                else
+                { fputc(d(string), stdout); }
+      string += 1; }
+    fputc(doubleChar, stdout); }
+
+//  WRITE ERROR OBJECTS. Write a JSON object on a line by itself for each error
+//  at NEXT PLACE, in lexicographic order of their MNEMONICs. Its COLUMN counts
+//  chars from the start of its line, so we need not reread the source file.
+
+  void writeErrorObjects()
+  { int err;
+    int index;
+    for (index = minErr + 1; index < maxErr; index += 1)
+    { err = intToErr[index];
+      if (isInSet(err, errs(nextPlace)))
+      { fputs("{\"path\":", stdout);
+        writeJsonString(path(file));
+        fprintf(stdout, ",\"line\":%i,\"column\":%i,\"mnemonic\":",
+         lineNumber, count(nextPlace) - count(lineSpot));
+        writeJsonString(errToMnemonic[err]);
+        fputs(",\"message\":", stdout);
+        writeJsonString(errToMessage[err]);
+        fputs("}\n", stdout); }}}
+
 //  NEXT LINE. Read the next line from SOURCE into LINE. If L is the ASCII line
 //  feed char, and R is the ASCII return char, then a line may be terminated by
 //  L, R, L R, or R L. The last line in SOURCE may also be terminated by an EOF
@@ -246,16 +353,6 @@ void writeErrorLines()
             lineEnd += 1; }
           break; }}}}
 
-//  NEXT CHAR. Copy the next char from LINE into CH. If LINE is empty, read the
-//  next line before we do it.
-
-  void nextChar()
-  { if (lineStart > lineEnd)
-    { nextLine(); }
-    ch = d(lineStart);
-    charCount += 1;
-    lineStart += 1; }
-
 //  WRITE ERROR LINE. If all sets in ERRS are empty, then do nothing. Otherwise
 //  write LINE NUMBER and its LINE. Then on the next line, at each column where
 //  an error occurred, write an arrow or caret followed by MNEMONICs describing
@@ -423,61 +520,49 @@ void writeErrorLines()
 
 //  Lost? This is WRITE ERROR LINES's body. Initialize.
 
+  file = nil;
   newline = "";
   errsEnd = errs;
   while (errsEnd < errs + maxErrsLength)
   { d(errsEnd) = setEmpty();
     errsEnd += 1; }
-
-//  Reread all Orson source files whose paths are in FILES. Each time we find a
-//  LINE with errors, we write that LINE, followed by one or more lines showing
-//  where its errors occurred.
-
-  file = next(firstFile);
-  while (file != nil && places != nil)
-  { if (isEnd(path(file), orsonPrelude) || isEnd(path(file), orsonSource))
-    { charCount = count(file);
-      errsEnd = errs;
-      lineNumber = 0;
-      titled = false;
-      source = fopen(path(file), "r");
-      if (source == nil)
-      { fail("Cannot open '%s' in writeErrors!", path(file)); }
-      else
-      { nextLine();
-        nextChar();
-        while (true)
-        { if (ch == eopChar)
-          { d(errsEnd) = getErrs(charCount);
-            errsEnd += 1;
-            nextChar();
-            d(errsEnd) = getErrs(charCount);
-            errsEnd += 1;
-            lineNumber += 1;
-            line[0] = eosChar;
-            writeErrorLine();
-            break; }
-          else if (ch == eosChar)
-               { d(errsEnd) = getErrs(charCount);
-                 errsEnd += 1;
-                 lineNumber += 1;
-                 writeErrorLine();
-                 errsEnd = errs;
-                 nextChar(); }
-               else
-               { d(errsEnd) = getErrs(charCount);
-                 errsEnd += 1;
-                 nextChar(); }}
-        if (fclose(source) != 0)
-        { fail("Cannot close '%s' in writeErrors!", path(file)); }}}
-    file = next(file); }
-
-//  We'd better have accounted for all errors in this way.
-
-  if (places != nil)
-  { fail("Errors remain unresolved in writeErrors!"); }}
-
-//  WRITE ERROR MESSAGES. Write messages that describe the ERRs in ALL ERRS.
+  sortPlaces();
+  nextPlace = places;
+  placesEnd = places + placesLength;
+  source = nil;
+
+//  Visit PLACES in order. If we're writing JSON, then we need only find a line
+//  and a column for each PLACE. Otherwise we seek to the start of each LINE in
+//  a source file that has errors, and reread only that LINE. Then we write it,
+//  followed by one or more lines showing where its errors occurred.
+
+  while (nextPlace < placesEnd)
+  { findFile();
+    findSpot();
+    if (jsoning)
+    { writeErrorObjects();
+      nextPlace += 1; }
+    else
+    { if (fseek(source, offset(lineSpot), SEEK_SET) != 0)
+      { fail("Cannot seek in '%s' in writeErrors!", path(file)); }
+      nextLine();
+      if (d(line) == eopChar)
+      { d(line) = eosChar; }
+      errsEnd = errs + (lineEnd - line) + 1;
+      while (isInLine())
+      { errsStart =
+         errs - 1 + min(count(nextPlace) - count(lineSpot), errsEnd - errs);
+        d(errsStart) = setUnion(d(errsStart), errs(nextPlace));
+        nextPlace += 1; }
+      writeErrorLine(); }}
+
+//  Clean up.
+
+  if (source != nil && fclose(source) != 0)
+  { fail("Cannot close '%s' in writeErrors!", path(file)); }}
+
+//  WRITE ERROR MESSAGES. Write messages that describe the ERRs in ALL ERRS. If
+//  we're writing JSON, then WRITE ERROR LINES already wrote them.
 
 void writeErrorMessages()
 { int     err;
@@ -488,7 +573,7 @@ void writeErrorMessages()
 
 //  Find the MAX LENGTH of the MNEMONICs for ERRs in ALL ERRS.
 
-  if (! isSetEmpty(allErrs))
+  if (! jsoning && ! isSetEmpty(allErrs))
   { maxLength = 0;
     for (err = minErr + 1; err < maxErr; err += 1)
     { if (isInSet(err, allErrs))
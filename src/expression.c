@@ -280,7 +280,7 @@ void emitExpression(refObject term, int oldPriority)
             while (true)
             { writeFormat(target, "if");
               writeChar(target, '(');
-              emitExpression(car(term), 13);
+              emitIfTest(term);
               writeChar(target, ')');
               term = cdr(term);
               if (isExceptional(car(term)))
@@ -578,7 +578,7 @@ void emitExpression(refObject term, int oldPriority)
 //  Write C code for a WITH without a mark frame.
 
           if (frame == nil)
-          { emitVariableDeclarations(temp);
+          { emitVariableDeclarations(frame, temp);
             emitFunctionDefinitions(true, temp);
             emitVariableDefinitions(nil, temp);
             temp = car(lastPair(temp));
@@ -599,10 +599,10 @@ void emitExpression(refObject term, int oldPriority)
 
           else
           { emitFrameDeclaration(frame, temp);
-            emitVariableDeclarations(temp);
+            emitVariableDeclarations(frame, temp);
             emitFunctionDefinitions(true, temp);
             if (isGroundSubtype(info(toRefTriple(term)), voidSimple))
-            { emitFramePush(frame, frameLength(temp));
+            { emitFramePush(frame);
               emitFrameInitialization(frame, temp);
               emitVariableDefinitions(frame, temp);
               temp = car(lastPair(temp));
@@ -612,7 +612,7 @@ void emitExpression(refObject term, int oldPriority)
               emitExpression(skip, 13); }
             else
             { emitVariableDeclaration(info(toRefTriple(term)), resultName);
-              emitFramePush(frame, frameLength(temp));
+              emitFramePush(frame);
               emitFrameInitialization(frame, temp);
               emitVariableDefinitions(frame, temp);
               temp = car(lastPair(temp));
@@ -33,6 +33,36 @@ void initFile()
   firstFile = makeFile("", -1);
   lastFile  = firstFile; }
 
+//  FIND LINE. Return the number of the line where the char whose count is
+//  COUNT appears in an Orson source file, and set PATH to that file's
+//  pathname. Lines are found by a binary search of the file's SPOTS, so we
+//  need not reread it. If we can't find the line, then set PATH to NIL and
+//  return 0.
+
+int findLine(refRefChar path, int count)
+{ refFile file;
+  int     high;
+  int     low;
+  int     mid;
+  int     start = (count >> charIndexBits) << charIndexBits;
+  file = next(firstFile);
+  while (file != nil && count(file) != start)
+  { file = next(file); }
+  if (file == nil || length(file) == 0 || count <= count(spots(file)))
+  { d(path) = nil;
+    return 0; }
+  else
+  { high = length(file) - 1;
+    low = 0;
+    while (low < high)
+    { mid = (low + high + 1) / 2;
+      if (count(spots(file) + mid) < count)
+      { low = mid; }
+      else
+      { high = mid - 1; }}
+    d(path) = path(file);
+    return low + 1; }}
+
 //  IS LOADED. Search the global chain whose head node is FIRST FILE. Test if a
 //  node contains the pathname PATH.
 
@@ -66,8 +96,28 @@ int makeCharCount()
   { fileCount += 1;
     return fileCount << charIndexBits; }}
 
+//  STARTS LINE. Assert that a line of the Orson source file recorded by FILE
+//  starts just after character count COUNT, at byte OFFSET. The end of a file
+//  may be read many times, as lines with lone EOP CHARs at the same OFFSET, so
+//  we record only the first of these. We double the size of FILE's SPOTS when
+//  it runs out of room.
+
+void startsLine(refFile file, int count, long offset)
+{ refSpot newSpot;
+  if (length(file) == 0 || offset(spots(file) + length(file) - 1) != offset)
+  { if (length(file) == limit(file))
+    { limit(file) = max(2 * limit(file), 256);
+      spots(file) = realloc(spots(file), limit(file) * spotSize);
+      if (spots(file) == nil)
+      { fail("Cannot record lines of '%s' in startsLine!", path(file)); }}
+    newSpot = spots(file) + length(file);
+    count(newSpot)  = count;
+    offset(newSpot) = offset;
+    length(file) += 1; }}
+
 //  WAS LOADED. Assert that the file whose pathname is PATH has been loaded and
-//  that its initial character count is COUNT.
+//  that its initial character count is COUNT. Return its new FILE.
 
-void wasLoaded(refChar path, int count)
-{ lastFile = (next(lastFile) = makeFile(path, count)); }
+refFile wasLoaded(refChar path, int count)
+{ lastFile = (next(lastFile) = makeFile(path, count));
+  return lastFile; }
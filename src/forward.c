@@ -22,8 +22,10 @@
 //  A REF or ROW type is FORWARDED if its base type is a name that has a binder
 //  in the current layer, but the binder asserts that the name's type and value
 //  are NIL. The name must then be bound in the same layer by a later equate. A
-//  forwarded pointer type has an invisible second argument linking it into the
-//  global chain BASES. The pointer type NULL is never forwarded.
+//  forwarded pointer type has an invisible second argument linking it into a
+//  chain of argument lists whose base types are the same name. The layer BASES
+//  binds each name to its chain, so binding the name visits only the pointer
+//  types that use it. The pointer type NULL is never forwarded.
 
 //  HAS FORWARD. Test if the pointer type TYPE has a second argument.
 
@@ -82,56 +84,53 @@ bool isForwarding(refObject type)
   destroyLayer(f.labeler);
   return found; }
 
-//  UPDATE POINTERS. Traverse BASES, a chain of REF and ROW argument lists. All
-//  base types in these lists are names.  If any of these names are bound, then
-//  replace them by their values.
+//  UPDATE POINTERS. Look up NAME in BASES, to get a chain of REF and ROW lists
+//  whose base types are NAME. If NAME is now bound, then replace it everywhere
+//  in the chain by its value. Delete each list's second argument, which points
+//  to the next list in the chain, and then delete the chain from BASES.
 
-void updatePointers()
-{ refObject left;
-  pair      leftHead;
+void updatePointers(refObject name)
+{ bool      isType;
   refObject next;
   refObject right;
-  pair      rightHead;
   refObject type;
   refObject value;
-
-//  Add a dummy argument list at the front of BASES, to simplify deletion.
-
-  left = r(leftHead);
-  leftHead.cdr = r(rightHead);
-  rightHead.car = bases;
-  right = bases;
-
-//  Traverse BASES. If we find an argument list whose first argument is a bound
-//  name, then replace the name by its value, delete the second argument (which
-//  points to the next argument list), and delete the argument list from BASES.
-
-  while (right != nil)
-  { next = cadr(right);
-    if (! gotKey(r(type), r(value), layers, car(right)) || type == nil)
-    { left = right;
-      right = next; }
-    else
-    { if (! isGroundSubtype(type, typeExeJoker))
+  if (
+   bases != nil &&
+   gotKey(toss, r(right), bases, name) &&
+   right != nil &&
+   gotKey(r(type), r(value), layers, name) &&
+   type != nil)
+  { isType = isGroundSubtype(type, typeExeJoker);
+    while (right != nil)
+    { next = cadr(right);
+      if (isType)
+      { car(right) = value; }
+      else
       { objectError(right, typeExeErr);
-        value = voidSimple; }
-      car(right) = value;
+        car(right) = voidSimple; }
       destroy(cdr(right));
       cdr(right) = nil;
-      right = (cadr(left) = next); }}
-
-//  Restore BASES from the head argument list.
-
-  bases = rightHead.car; }
-
-//  UPDATE PROCEDURES. Remove a PROC closure from a queue, whose front is FIRST
-//  PROC and whose rear is LAST PROC. Transform and update the closure, perhaps
-//  adding more closures to the queue. Continue until the queue is empty.
+      right = next; }
+    setKey(bases, name, nil, nil); }}
 
-void updateProcedures()
-{ struct
+//  UPDATE PROCEDURE. Transform and update the PROC closure CLOSE, perhaps by
+//  adding more closures to the queue whose front is FIRST PROC and whose rear
+//  is LAST PROC. If we're measuring costs, then charge what it cost to CLOSE's
+//  body (see ORSON/COST).
+//
+//  The closure's body is transformed in a context of its own. It sees only the
+//  LAYERS that were current when the closure was made, and no CALLS or MATCHES
+//  left over from whatever was being transformed when we were called. So each
+//  closure is transformed the same way, no matter when its queue is emptied.
+
+void updateProcedure(refObject close)
+{ cost    meter;
+  refCall oldCalls;
+  struct
   { refFrame  link;
     int       count;
+    refMatch  oldMatches;
     refObject body;
     refObject close;
     refObject first;
@@ -146,86 +145,99 @@ void updateProcedures()
     refObject value;
     refObject yield; } f;
 
-//  Break each closure into a TYPE, a LAYER, and a BODY.
+//  Break the closure into a TYPE, a LAYER, and a BODY.
 
-  push(f, 13);
-  while (firstProc != nil)
-  { f.close = dequeue(r(firstProc), r(lastProc));
-    f.close = cdr(f.close); f.type  = car(f.close);
-    f.temp  = cdr(f.close); f.layer = car(f.temp);
-    f.temp  = cdr(f.temp);  f.body  = car(f.temp);
+  push(f, 14);
+  f.close = cdr(close);   f.type  = car(f.close);
+  f.temp  = cdr(f.close); f.layer = car(f.temp);
+  f.temp  = cdr(f.temp);  f.body  = car(f.temp);
+  if (maxCostCount > 0)
+  { startCost(r(meter)); }
 
 //  Break the TYPE into a list of parameters PARS and a YIELD type. Establish a
 //  new LAYER to bind parameter names.
 
-    f.type = cdr(f.type); f.pars  = car(f.type);
-    f.type = cdr(f.type); f.yield = car(f.type);
-    f.layer = pushLayer(f.layer, plainInfo);
+  f.type = cdr(f.type); f.pars  = car(f.type);
+  f.type = cdr(f.type); f.yield = car(f.type);
+  f.layer = pushLayer(f.layer, plainInfo);
 
 //  Bind each parameter name to a stub in LAYER. If the parameter name has type
 //  VAR, then bind it to the stub prefixed by VAR TO. As we go, construct a new
 //  parameter list where the stubs appear instead of their corresponding names.
 
-    if (f.pars == nil)
-    { f.first = nil; }
-    else
+  if (f.pars == nil)
+  { f.first = nil; }
+  else
 
 //  Do the first parameter name.
 
+  { f.type = car(f.pars); f.pars = cdr(f.pars);
+    f.name = car(f.pars); f.pars = cdr(f.pars);
+    f.stub = makeStub(f.name);
+    f.last = makePair(f.stub, nil);
+    f.first = makePair(f.type, f.last);
+    if (isCar(f.type, varHook))
+    { f.value = makePair(cadr(f.type), nil);
+      f.value = makePair(f.stub, f.value);
+      f.value = makePair(hooks[varToHook], f.value); }
+    else
+    { f.value = f.stub; }
+    setKey(f.layer, f.name, f.type, f.value);
+
+//  Do the remaining parameter names.
+
+    while (f.pars != nil)
     { f.type = car(f.pars); f.pars = cdr(f.pars);
       f.name = car(f.pars); f.pars = cdr(f.pars);
       f.stub = makeStub(f.name);
-      f.last = makePair(f.stub, nil);
-      f.first = makePair(f.type, f.last);
+      f.last = (cdr(f.last) = makePair(f.type, nil));
+      f.last = (cdr(f.last) = makePair(f.stub, nil));
       if (isCar(f.type, varHook))
       { f.value = makePair(cadr(f.type), nil);
         f.value = makePair(f.stub, f.value);
         f.value = makePair(hooks[varToHook], f.value); }
       else
       { f.value = f.stub; }
-      setKey(f.layer, f.name, f.type, f.value);
-
-//  Do the remaining parameter names.
-
-      while (f.pars != nil)
-      { f.type = car(f.pars); f.pars = cdr(f.pars);
-        f.name = car(f.pars); f.pars = cdr(f.pars);
-        f.stub = makeStub(f.name);
-        f.last = (cdr(f.last) = makePair(f.type, nil));
-        f.last = (cdr(f.last) = makePair(f.stub, nil));
-        if (isCar(f.type, varHook))
-        { f.value = makePair(cadr(f.type), nil);
-          f.value = makePair(f.stub, f.value);
-          f.value = makePair(hooks[varToHook], f.value); }
-        else
-        { f.value = f.stub; }
-        setKey(f.layer, f.name, f.type, f.value); }}
+      setKey(f.layer, f.name, f.type, f.value); }}
 
 //  Make a new PROC type from the new parameter list. Replace the old PROC type
 //  in the closure. All this is needed to avoid inadvertent capture of names by
 //  form expansion.
 
-    f.last = makePair(f.yield, nil);
-    f.first = makePair(f.first, f.last);
-    f.first = makePair(hooks[procHook], f.first);
-    car(f.close) = f.first;
+  f.last = makePair(f.yield, nil);
+  f.first = makePair(f.first, f.last);
+  f.first = makePair(hooks[procHook], f.first);
+  car(f.close) = f.first;
 
 //  Transform the BODY of the PROC in LAYER, which must have an execution TYPE.
 //  Its TYPE must also coerce to the YIELD type or the YIELD type must be VOID.
 //  In the latter case, we don't coerce VALUE to VOID, because the PROC will be
 //  translated to a C function that does not return a value.
 
-    f.layers = layers;
-    layers = f.layer;
-    transform(r(f.type), r(f.value), f.body);
-    if (isGroundSubtype(f.type, exeJoker))
-    { if (! isGroundCoerced(r(f.type), r(f.value), f.yield))
-      { if (! isGroundSubtype(f.yield, voidSimple))
-        { objectError(f.body, typeErr);
-          f.value = skip; }}}
-    else
-    { objectError(f.body, exeErr);
-      f.value = skip; }
-    car(f.body) = f.value;
-    layers = f.layers; }
+  f.layers = layers; layers = f.layer;
+  oldCalls = calls; calls = nil;
+  f.oldMatches = matches; matches = nil;
+  transform(r(f.type), r(f.value), f.body);
+  if (isGroundSubtype(f.type, exeJoker))
+  { if (! isGroundCoerced(r(f.type), r(f.value), f.yield))
+    { if (! isGroundSubtype(f.yield, voidSimple))
+      { objectError(f.body, typeErr);
+        f.value = skip; }}}
+  else
+  { objectError(f.body, exeErr);
+    f.value = skip; }
+  car(f.body) = f.value;
+  layers = f.layers;
+  calls = oldCalls;
+  matches = f.oldMatches;
+  if (maxCostCount > 0)
+  { stopCost(r(meter), info(f.body)); }
   pop(); }
+
+//  UPDATE PROCEDURES. Remove PROC closures from the queue whose front is FIRST
+//  PROC and whose rear is LAST PROC, and update each one. Updating a closure
+//  may add more closures to the queue, so continue until the queue is empty.
+
+void updateProcedures()
+{ while (firstProc != nil)
+  { updateProcedure(dequeue(r(firstProc), r(lastProc))); }}
@@ -80,6 +80,7 @@
 #define illegalChar      0xFFFD          //  UTF-32 illegal char.
 #define linefeedChar     0x0A            //  ASCII linefeed char.
 #define maxChar          0x7FFFFFFF      //  Maximum possible char.
+#define maxUnicodeChar   0x10FFFF        //  Maximum Unicode char.
 #define minusChar        0x2212          //  UTF-32 minus sign.
 #define noBreakBlank     0xA0            //  UTF-32 nonbreaking blank.
 #define returnChar       0x0D            //  ASCII carriage return char.
@@ -90,8 +91,10 @@
 //  Count and length constants.
 
 #define bitsPerInt        32        //  Bits in an INT.
+#define blockSize         65536     //  Initial bytes in a BUFFER's block.
 #define boldCount         74        //  Number of "bold" names.
 #define charIndexBits     21        //  Bits in a file char index.
+#define costsLength       1024      //  Buckets in COSTS.
 #define heapSize          1048576   //  Bytes in a HEAP.
 #define hexDigitsPerInt   8         //  Hex digits in an INT.
 #define intsPerSet        8         //  For 256-element SETs.
@@ -119,6 +122,7 @@
 #define F                false               //  Abbreviation for FALSE.
 #define false            0                   //  A fake FALSE value.
 #define fileBytes        st_size             //  Because it's ugly.
+#define fromStdin        "-x c -"            //  Make GCC read C code on STDIN.
 #define hexDigits        "0123456789ABCDEF"  //  Hexadecimal digits.
 #define hexRealsAllowed  true                //  Hex real constants supported?
 #define hunkAlign        alignof(double)     //  Alignment of HUNKs in a HEAP.
@@ -128,6 +132,7 @@
 #define orsonPrelude     ".op"               //  Orson prelude file extension.
 #define orsonSource      ".os"               //  Orson source file extension.
 #define outRange         ERANGE              //  Because it's ugly.
+#define pthreads         "-pthread "         //  Make GCC use POSIX threads.
 #define T                true                //  Abbreviation for TRUE.
 #define targetFile       "Out"               //  File to receive C code.
 #define toss             r(tossed)           //  Points to an ignored pointer.
@@ -146,6 +151,7 @@
 //  on either side of "=".
 
 #define bytes(term)      ((term)->bytes)
+#define calls(term)      ((term)->calls)
 #define car(term)        (term)->car
 #define cdr(term)        (term)->cdr
 #define caar(term)       car(car(term))
@@ -177,28 +183,40 @@
 #define cdddar(term)     cdr(cdr(cdr(car(term))))
 #define cddddr(term)     cdr(cdr(cdr(cdr(term))))
 #define chars(term)      ((term)->chars)
+#define child(term)      ((term)->child)
+#define children(term)   ((term)->children)
 #define count(term)      ((term)->count)
 #define degree(term)     ((term)->degree)
+#define duration(term)   ((term)->duration)
 #define end(term)        ((term)->end)
 #define errs(term)       ((term)->errs)
+#define exclusive(term)  ((term)->exclusive)
+#define filling(term)    ((term)->filling)
 #define first(term)      ((term)->first)
 #define hunks(term)      ((term)->hunks)
+#define inclusive(term)  ((term)->inclusive)
 #define indent(term)     ((term)->indent)
 #define index(term)      ((term)->index)
 #define info(term)       ((term)->info)
 #define key(term)        ((term)->key)
+#define last(term)       ((term)->last)
 #define lastHunk(term)   ((term)->lastHunk)
 #define layer(term)      ((term)->layer)
 #define left(term)       ((term)->left)
 #define leftLayer(term)  ((term)->leftLayer)
 #define leftType(term)   ((term)->leftType)
 #define length(term)     ((term)->length)
+#define limit(term)      ((term)->limit)
+#define line(term)       ((term)->line)
 #define link(term)       ((term)->link)
 #define marked(term)     ((term)->marked)
 #define next(term)       ((term)->next)
 #define number(term)     ((term)->number)
 #define object(term)     ((term)->object)
+#define offset(term)     ((term)->offset)
+#define parent(term)     ((term)->parent)
 #define path(term)       ((term)->path)
+#define procs(term)      ((term)->procs)
 #define refs(term)       ((term)->refs)
 #define right(term)      ((term)->right)
 #define rightLayer(term) ((term)->rightLayer)
@@ -206,6 +224,7 @@
 #define self(term)       ((term)->self)
 #define size(term)       ((term)->size)
 #define space(term)      ((term)->space)
+#define spots(term)      ((term)->spots)
 #define start(term)      ((term)->start)
 #define state(term)      ((term)->state)
 #define stream(term)     ((term)->stream)
@@ -214,6 +233,7 @@
 #define temp(term)       ((term)->temp)
 #define test(term)       ((term)->test)
 #define token(term)      ((term)->token)
+#define transforms(term) ((term)->transforms)
 #define type(term)       ((term)->type)
 #define value(term)      ((term)->value)
 
@@ -313,7 +333,6 @@
 #define hunked(size)         ((size) + rounder((size), (hunkAlign)))
 #define max(left, right)     ((left) > (right) ? (left) : (right))
 #define min(left, right)     ((left) < (right) ? (left) : (right))
-#define ranges(term)         (sizeof(term) / sizeof(range))
 #define rounder(size, align) (- (size) & ((align) - 1))
 
 //  Macros for the GC frame stack. (See FRAME below, and ORSON/HUNK.)
@@ -755,10 +774,13 @@ typedef struct stat        status;            //  Holds the status of a file.
 //  Structure types in alphabetical order where possible. DEGREEs and SIZEs are
 //  used when allocating objects from the heap. (See ORSON/MAKE.)
 
-//  BUFFER. A buffer for writing text to STREAM. The first INDENT chars of each
-//  written line are blanks, followed by at most LENGTH remaining chars, with a
-//  maximum of MAX BUFFER LENGTH chars per line. START accumulates the chars to
-//  be written; its last char is a sentinel. END is where to add the next char.
+//  BUFFER. A buffer for writing text to STREAM. Chars accumulate in a growable
+//  block that starts at START and ends just before LIMIT. END is where to add
+//  the next char, and LINE is where the chars of the current line begin. The
+//  block is written to STREAM all at once when it's flushed. If FILLING is
+//  TRUE, then the first INDENT chars of each line are blanks, followed by at
+//  most LENGTH remaining chars, with a maximum of MAX BUFFER LENGTH chars per
+//  line. If FILLING is FALSE, then lines end only when the BUFFER is flushed.
 //  (See ORSON/BUFFER.)
 
 #define bufferSize sizeof(buffer)
@@ -768,9 +790,12 @@ typedef struct bufferStruct *refBuffer;
 
 struct bufferStruct
 { refChar   end;
+  bool      filling;
   int       indent;
   int       length;
-  char      start[maxBufferLength + 1];
+  refChar   limit;
+  refChar   line;
+  refChar   start;
   refStream stream; };
 
 //  CHARACTER. Represent an Orson UTF-32 char.
@@ -788,6 +813,26 @@ struct characterStruct
   char tag;
   int  self; };
 
+//  COST. Record what it cost to transform the PROCs whose bodies start at char
+//  count COUNT. PROCS is how many of them there were. DURATION is how many
+//  seconds of processor time they took. TRANSFORMS is how many times they
+//  called TRANSFORM. BYTES is how many bytes of HUNKs they made. COSTs with
+//  the same hash are linked into a chain through their NEXT slots. (See
+//  ORSON/COST.)
+
+#define costSize sizeof(cost)
+
+typedef struct costStruct cost;
+typedef struct costStruct *refCost;
+
+struct costStruct
+{ long    bytes;
+  int     count;
+  double  duration;
+  refCost next;
+  int     procs;
+  long    transforms; };
+
 //  FILE. Assert that the file denoted by the pathname PATH is loaded, and that
 //  its char count starts at COUNT. A char count is an INT, with FILE and INDEX
 //  fields. Its FILE field is the unique number of the file. Its INDEX field is
@@ -804,17 +849,33 @@ struct characterStruct
 //  at most MAX FILE COUNT nodes in the chain to keep from overflowing the FILE
 //  field. We never check INDEX fields for overflow, so all our files must have
 //  fewer than (1 << CHAR INDEX BITS) chars. (See ORSON/ERROR and ORSON/FILE.)
+//
+//  SPOTS is an array of LIMIT SPOTs. Its first LENGTH SPOTs tell where lines
+//  of an Orson source file start, in the order they were read. A SPOT's COUNT
+//  is the char count just before the first char of its line, and OFFSET is the
+//  byte offset of that char in the file. We record them while we load a file,
+//  so we can later seek directly to the lines that have errors.
 
 #define fileSize sizeof(file)
+#define spotSize sizeof(spot)
 
 typedef struct fileStruct file;
 typedef struct fileStruct *refFile;
+typedef struct spotStruct spot;
+typedef struct spotStruct *refSpot;
 
 struct fileStruct
 { int     count;
+  int     length;
+  int     limit;
   refChar path;
+  refSpot spots;
   refFile next; };
 
+struct spotStruct
+{ int  count;
+  long offset; };
+
 //  HOOK. Used as a pointer to code in TRANSFORM, or as a distinguished symbol.
 //  STRING is the HOOK's printed representation. SELF is an index into the hook
 //  table HOOKS. (See ORSON/TRANSFORM and ORSON/LOAD.)
@@ -900,6 +961,34 @@ struct nameStruct
   refName left;
   refName right; };
 
+//  TRACE. Record calls made by TRANSFORM in a tree, whose paths from its root
+//  are stacks of calls. KEY tells what was called. If it's not negative, then
+//  it's a hook. If it's negative, then it's a form whose body starts at char
+//  count -1 - KEY, and whose name is STRING (or NIL if it has none). CALLS is
+//  how many times it was called, INCLUSIVE is how many seconds these calls
+//  took, and EXCLUSIVE is how many of those seconds weren't spent in calls to
+//  its children. START and CHILDREN are used while a call is in progress: when
+//  it began, and how many seconds its children took. CHILD is the first child
+//  of this TRACE, NEXT is its next sibling, and PARENT is its parent. (See
+//  ORSON/TRACE.)
+
+#define traceSize sizeof(trace)
+
+typedef struct traceStruct trace;
+typedef struct traceStruct *refTrace;
+
+struct traceStruct
+{ long     calls;
+  double   children;
+  double   exclusive;
+  double   inclusive;
+  int      key;
+  double   start;
+  refChar  string;
+  refTrace child;
+  refTrace next;
+  refTrace parent; };
+
 //  NODE. Objects to be managed by the garbage collector look like this. DEGREE
 //  is the number of pointers visible to the GC. SIZE is the size (in bytes) of
 //  this object. STATE is the number of visible pointers which have been marked
@@ -1060,18 +1149,6 @@ struct matchStruct
   refObject rightType;
   refMatch  next; };
 
-//  RANGE. A range of one or more UTF-32 characters from MIN to MAX, inclusive.
-//  All RANGEs reside in arrays whose elements are in increasing order. They're
-//  used to compute how many columns are required to display a UTF-32 char. The
-//  macro RANGES returns the length of such an array. (See ORSON/CHAR.)
-
-typedef struct rangeStruct range;
-typedef struct rangeStruct *refRange;
-
-struct rangeStruct
-{ int min;
-  int max; };
-
 //  REAL. Represent an Orson REAL.
 
 #define realDegree 0
@@ -1105,7 +1182,8 @@ struct sizeStruct
 
 //  SNIP. A segment of a STRING. SNIPs form a singly linked linear list through
 //  their NEXT slots. SELF is an array of CHARs, not terminated by an EOS CHAR.
-//  See STRING below for details.
+//  COUNT is how many bytes of SELF have been written so far. CHARS is how many
+//  of those bytes start UTF-8 encoded chars. See STRING below for details.
 
 #define snipDegree 1
 #define snipSize max(hunkSize, hunked(sizeof(snip)))
@@ -1118,19 +1196,24 @@ struct snipStruct
   char    size;
   char    state;
   char    tag;
+  char    count;
+  char    chars;
   refSnip next;
   char    self[maxSnipLength]; };
 
 //  STRING. A string of chars. Every STRING has a singly linked linear chain of
-//  zero or more SNIPs. FIRST is the initial SNIP in the chain. The first BYTES
-//  bytes, and the first UTF-8 encoded CHARS chars in the chain, constitute the
-//  string. In an empty string, FIRST is NIL, BYTES is 0, and CHARS is 0.
+//  zero or more SNIPs. FIRST is the initial SNIP in the chain, and LAST is the
+//  SNIP that holds the string's final byte. Every SNIP before LAST is full.
+//  The first BYTES bytes and the first UTF-8 encoded CHARS chars in the chain
+//  are the string. In an empty string, FIRST and LAST are NIL, and BYTES and
+//  CHARS are 0. STRINGs never change once they're made, so many of them may
+//  share the same SNIPs. (See ORSON/STRING.)
 //
 //  Sometimes we say STRING to mean a REF CHAR, a pointer to an array of CHARs,
 //  terminated by an EOS CHAR: this is a C string. Other times we say STRING to
 //  mean a REF STRING: this is an Orson string. Don't be confused.
 
-#define stringDegree 1
+#define stringDegree 2
 #define stringSize max(hunkSize, hunked(sizeof(string)))
 
 typedef struct stringStruct string;
@@ -1142,6 +1225,7 @@ struct stringStruct
   char    state;
   char    tag;
   refSnip first;
+  refSnip last;
   int     bytes;
   int     chars; };
 
@@ -1176,9 +1260,9 @@ struct setStruct
 { int bits[intsPerSet]; };
 
 //  PLACE. Assert that the syntax errors in ERRS were found at character number
-//  COUNT while reading a source file. PLACEs are linked together into a linear
-//  chain via their NEXT slots, in increasing order of their COUNT slots.  (See
-//  ORSON/ERROR).
+//  COUNT while reading a source file. PLACEs are appended to the array PLACES
+//  in the order their errors were found, and sorted by their COUNT slots only
+//  when the errors are written. (See ORSON/ERROR).
 
 #define placeSize sizeof(place)
 
@@ -1186,9 +1270,8 @@ typedef struct placeStruct place;
 typedef struct placeStruct *refPlace;
 
 struct placeStruct
-{ int      count;
-  set      errs;
-  refPlace next; };
+{ int count;
+  set errs; };
 
 //  JOKER. Represent a set of hooks SELF as an Orson type. JOKERs are wildcards
 //  that match types whose corresponding HOOKs are members of SELF. They always
@@ -1240,7 +1323,9 @@ int       charHigh(refObject);
 int       charLow(refObject);
 int       charWidth(int);
 void      check(refChar, refObject);
+int       countChars(refChar, int);
 int       countPairs(refObject);
+void      deferDefinitions(refObject);
 void      destroy(refVoid);
 void      destroyPairs(refPair);
 refObject destroyLayer(refObject);
@@ -1250,37 +1335,41 @@ refObject devar(refObject);
 refObject dewith(refObject);
 int       dirtyLength(refChar);
 refChar   dirtyToClean(int);
+void      elideFrames(refObject);
 void      emitAssignment(refObject, refObject);
 void      emitCastDeclaration(refObject);
 void      emitDeclaration(refVoidFunc, refObject);
+void      emitDefinitions();
 void      emitExpression(refObject, int);
 void      emitFrameAssignment(refObject, refObject, refObject);
 void      emitFrameDeclaration(refObject, refObject);
 void      emitFrameInitialization(refObject, refObject);
 void      emitFrameName(refObject, refObject);
 void      emitFramePop(refObject);
-void      emitFramePush(refObject, int);
+void      emitFramePush(refObject);
+void      emitFunctionAttributes(refObject);
 void      emitFunctionDeclaration(refObject, refObject);
+void      emitFunctionDeclarations(bool, refObject);
 void      emitFunctionDefinition(refObject, refObject);
 void      emitFunctionDefinitions(bool, refObject);
+void      emitIfTest(refObject);
 void      emitInitializerDeclaration();
 void      emitLabels(refObject);
 void      emitMain();
 void      emitProgram(refObject);
 void      emitStatement(refObject, set);
 void      emitVariableDeclaration(refObject, refObject);
-void      emitVariableDeclarations(refObject);
+void      emitVariableDeclarations(refObject, refObject);
 void      emitVariableDefinitions(refObject, refObject);
 refChar   encodeChar(int);
 void      enqueue(refRefObject, refRefObject, refObject);
 void      fail(refChar, ...) attribute ((noreturn));
+int       findLine(refRefChar, int);
 void      finishLast(refRefObject, refRefObject, refObject, refObject);
 refObject flatten(refObject);
 void      formConcatenate(refRefObject, refRefObject, refObject, refObject);
-int       frameLength(refObject);
 int       getChar(refStream);
 int       getCount(refObject);
-set       getErrs(int);
 void      getKey(refRefObject, refRefObject, refObject, refObject);
 bool      gotKey(refRefObject, refRefObject, refObject, refObject);
 refObject groundify(refObject, refObject);
@@ -1288,6 +1377,7 @@ bool      hasForward(refObject);
 bool      hasVariables(refObject);
 refChar   hookTo(refObject);
 void      initBuffer();
+void      initCost();
 void      initEmit();
 void      initError();
 void      initExpression();
@@ -1296,11 +1386,13 @@ void      initHunk();
 void      initLayer();
 void      initLoad();
 void      initMake();
+void      initOptimize();
 void      initPrelude();
 void      initSignal();
 void      initSize();
 void      initStatement();
 void      initSubtype();
+void      initTrace();
 void      initTransform();
 void      insertErr(int, int);
 int       intHigh(refObject);
@@ -1315,6 +1407,7 @@ void      internSize(int, refObject);
 bool      isApplicable(refObject, refObject, refObject, refObject);
 bool      isApplied(refRefObject, refRefObject, refObject, int, ...);
 bool      isBindable(refObject, refObject);
+bool      isBoolean(refObject);
 bool      isCalled(refObject, refObject);
 bool      isCoerced(refRefObject, refRefObject, refObject, refObject);
 bool      isCoercing(refBoolFunc, refObject, refObject, refObject, refObject);
@@ -1348,6 +1441,7 @@ bool      isProcEquate(refObject, refObject);
 bool      isRemovable(refObject, refObject);
 bool      isRomanChar(char);
 bool      isRomanOrDigitChar(char);
+bool      isSameTerm(refObject, refObject);
 bool      isSetEmpty(set);
 bool      isSized(refObject);
 bool      isStart(refChar, refChar);
@@ -1366,12 +1460,13 @@ void      lineError(int);
 void      loadC(refChar, refStream);
 void      loadOrson(refChar, refStream, bool);
 refBinder makeBinder(refObject, refObject, refObject);
-refBuffer makeBuffer(refStream, int);
+refBuffer makeBuffer(refStream, int, bool);
 refObject makeCell(refObject, refObject);
 int       makeCharCount();
 refObject makeCharacter(int);
 refObject makeCharacterCast(refObject, refObject);
 refObject makeCharacterType(int);
+refCost   makeCost(int);
 refFile   makeFile(refChar, int);
 refVoid   makeHunk(int);
 refObject makeInteger(int);
@@ -1381,7 +1476,6 @@ refMatch  makeMatch(refObject, refObject, refObject, refObject);
 refName   makeName(refChar, int);
 refObject makePair(refObject, refObject);
 refObject makePaire(refObject, refObject, int);
-refPlace  makePlace(int, int, refPlace);
 refObject makePrefix(int, refObject);
 refObject makeReal(double);
 refObject makeRealCast(refObject, refObject);
@@ -1389,6 +1483,7 @@ refSize   makeSize(int);
 refSnip   makeSnip();
 refString makeString();
 refObject makeStub(refObject);
+refTrace  makeTrace(int, refChar, refTrace);
 refObject makeTriple(refObject, refObject, refObject);
 refObject makeVoidCast(refObject);
 refObject makingJoker(refChar, int, ...);
@@ -1396,12 +1491,14 @@ set       makingSet(int, ...);
 refObject nameAppend(refObject, refObject);
 void      objectError(refObject, int);
 refStream openPortablePath(refChar, refChar);
+void      optimize(refObject);
 refObject popLayer(refObject);
 void      popMatches(int);
 void      pushFrame(refFrame, int);
 refObject pushLayer(refObject, int);
 void      pushMatch(refObject, refObject, refObject, refObject);
 void      putChar(refStream, int);
+double    processorTime();
 double    realHigh(refObject);
 double    realLow(refObject);
 int       removeChar(refRefChar);
@@ -1415,28 +1512,44 @@ set       setRemove(set, int);
 set       setUnion(set, set);
 refObject skolemize(refObject, refObject);
 void      sourceError(int);
+void      startCost(refCost);
+void      startsLine(refFile, int, long);
+void      startTrace(int, refChar);
+void      startTraceForm(refObject, refObject);
+void      stopCost(refCost, int);
+void      stopTrace();
+void      stringAppendByte(refString, char);
+void      stringAppendBuffer(refString, refChar, int);
+void      stringAppendBytes(refString, refSnip, int, int);
 int       stringChar(refString, int);
 int       stringCompare(refString, refString);
 refString stringConcatenate(refString, refString);
+refString stringExtend(refString);
+void      stringGrow(refString);
+int       stringOffset(refString, int);
 refString stringPostfix(refString, int);
 refString stringPrefix(int, refString);
+refSnip   stringSnip(refString, int);
 void      stringToBuffer(refChar, refString);
 refString substring(refString, int, int);
 refObject supertype(refObject, refObject);
 refTriple toRefTriple(refObject);
+double    traceTime();
 void      transform(refRefObject, refRefObject, refObject);
 int       typeAlign(refObject);
 int       typeSize(refObject);
 void      unskolemize(refObject, refObject);
-void      updatePointers();
+void      updatePointers(refObject);
+void      updateProcedure(refObject);
 void      updateProcedures();
-void      wasLoaded(refChar, int);
+refFile   wasLoaded(refChar, int);
 void      writeChar(refBuffer, char);
 void      writeCharacter(refBuffer, int);
 void      writeBlank(refBuffer);
 void      writeBuffer(refBuffer);
 void      writeChars(refStream, int, char);
 void      writeCleanName(refBuffer, refChar);
+void      writeCosts();
 void      writeDirtyName(refBuffer, refChar, int);
 void      writeErrorLines();
 void      writeErrorMessages();
@@ -1444,6 +1557,7 @@ void      writeExactReal(refBuffer, double);
 void      writeFormat(refBuffer, refChar, ...);
 void      writeHerald(refStream);
 void      writeLayer(refObject);
+void      writeLine(refBuffer);
 void      writeMatch(refMatch);
 void      writeMatches(refMatch);
 void      writeNakedString(refBuffer, refString);
@@ -1454,6 +1568,7 @@ void      writeQuotedString(refBuffer, refString);
 void      writeSet(refStream, set);
 void      writeToken(refStream, int, refChar);
 void      writeTokenSet(refStream, set);
+void      writeTraces();
 void      writeVisibleName(refBuffer, refObject);
 void      writingObject(refBuffer, refObject);
 
@@ -1462,7 +1577,8 @@ void      writingObject(refBuffer, refObject);
 set       allErrs;                      //  Set of all errors in SOURCEs.
 bool      asciiing;                     //  Are we writing messages in ASCII?
 refObject assignerName;                 //  The name ":=".
-refObject bases;                        //  Untransformed pointer base types.
+refObject baseName;                     //  Name of the FRAME BASE pointer.
+refObject bases;                        //  Forwarded pointer types by name.
 refObject boldCatchName;                //  The name "catch".
 set       boldDoCloseParenSet;          //  Set of "do" and ")" tokens.
 set       boldDoInSet;                  //  Set of "do" and "in" tokens.
@@ -1479,12 +1595,14 @@ int       charCount;                    //  Count chars read from source.
 refObject char0Simple;                  //  The simple type CHAR0.
 refObject char1Simple;                  //  The simple type CHAR1.
 refObject characterZero;                //  The null character.
+cost      charged;                      //  Total costs charged to PROCs.
 set       closeBraceSet;                //  Set of the "}" token.
 set       closeBracketSet;              //  Set of the "]" token.
 set       closeParenSet;                //  Set of the ")" token.
 set       closeParenColonSet;           //  Set of ")" and ":" tokens.
 set       closeParenNameSet;            //  Set of ")" and name tokens.
 set       closeParenSemicolonSet;       //  Set of ")" and ";" tokens.
+refObject collectors;                   //  Names of PROCs that might collect.
 set       colonSet;                     //  Set of the ":" token.
 set       colonCommaSet;                //  Set of ":" and "," tokens.
 set       colonDashNameSet;             //  Set of ":-" and name tokens.
@@ -1492,16 +1610,23 @@ set       colonTermSet;                 //  Set of ":" and term tokens.
 set       commaSet;                     //  Set of ",".
 set       commaNameSet;                 //  Set of "," and name tokens.
 set       comparisonSet;                //  Set of comparison operator tokens.
-refObject countName;                    //  Slot name in a mark frame.
+refCost   costs[costsLength];           //  Bucketed hash table of COSTs.
 refBuffer debug;                        //  Buffer for debugging output.
+refBuffer deferred;                     //  Buffer for C code of PROCs.
+size_t    deferredLength;               //  Chars in DEFERRED TEXT.
+refChar   deferredText;                 //  C code written by DEFERRED.
+refObject definitions;                  //  Binds PROC names to their C code.
 refObject dotName;                      //  The name ".".
+double    emitTime;                     //  Seconds spent writing PROGs in C.
 refObject emptyAlts;                    //  The type (ALTS).
 refObject emptyClosure;                 //  A closure with no members.
 refObject emptyString;                  //  The string constant ''''.
+refObject endName;                      //  Name of the end of the mark frames.
 refChar   errToMessage[maxErr + 1];     //  Map ERRs to error message strings.
 refChar   errToMnemonic[maxErr + 1];    //  Map ERRs to error mnemonic strings.
 refObject exeJoker;                     //  All execution time types.
 int       fileCount;                    //  Count FILEs being loaded.
+refObject firstDefinition;              //  Front of deferred PROC queue.
 refObject firstProc;                    //  Front of PROC closure queue.
 refFile   firstFile;                    //  Head node in the chain of FILEs.
 bool      flag;                         //  A temporary Boolean.
@@ -1517,6 +1642,7 @@ refObject greaterEqualName;             //  The name ">=".
 label     halt;                         //  LONGJMP here to halt Orson.
 refHeap   heaps;                        //  The chain of HEAPs.
 int       heapCount;                    //  How many HEAPs to make.
+long      hunkBytes;                    //  Count bytes in HUNKs made so far.
 refObject hooks[maxHook + 1];           //  Table of HOOKs.
 set       ifLastWithSet;                //  A set of IF, LAST, and WITH HOOKs.
 int       initCount;                    //  Counts initialization functions.
@@ -1528,8 +1654,11 @@ refObject injJoker;                     //  All integer types.
 refObject integerOne;                   //  The integer 1.
 refObject integerMinusOne;              //  The integer -1.
 refObject integerZero;                  //  The integer 0.
+bool      jsoning;                      //  Are we writing errors as JSON?
+refObject lastDefinition;               //  Rear of deferred PROC queue.
 refFile   lastFile;                     //  Last FILE in the chain of FILEs.
 refObject lastProc;                     //  Rear of PROC closure queue.
+refTrace  lastTrace;                    //  TRACE of the call in progress.
 set       lastWithSet;                  //  A set of LAST and WITH HOOKs.
 refObject layers;                       //  Top of the BINDER tree stack.
 refObject leftBracesName;               //  The name "{} ".
@@ -1539,13 +1668,14 @@ refObject lessEqualName;                //  The name "<=".
 refObject lessGreaterName;              //  The name "<>".
 refObject lessLessEqualName;            //  The name "<<=".
 refObject lessLessName;                 //  The name "<<".
-refObject linkName;                     //  Slot name in a mark frame.
 refObject listSimple;                   //  The simple type LIST.
 int       level;                        //  Count pending calls to TRANSFORM.
+long      liveBytes;                    //  Count bytes in HUNKs in use.
 refObject markable;                     //  Visit pointers with this type.
 refObject markingName;                  //  Bound if we're marking names.
 refMatch  matches;                      //  Chain of MATCHes to be solved.
 int       maxBoldLength;                //  Chars in longest bold name.
+int       maxCostCount;                 //  How many COSTs to write.
 int       maxDebugLevel;                //  Control TRANSFORM's debug trace.
 int       maxLevel;                     //  Max recursive calls to TRANSFORM.
 int       minBoldLength;                //  Chars in shortest bold name.
@@ -1557,15 +1687,22 @@ set       nameSet;                      //  Set of name tokens.
 refObject noName;                       //  The missing name.
 refObject nullSimple;                   //  The type of NIL.
 refObject objJoker;                     //  All types.
+double    optimizeTime;                 //  Seconds spent optimizing PROGs.
+long      peakBytes;                    //  Most bytes ever in HUNKs in use.
 refPlace  places;                       //  Holds locations of errors.
+int       placesLength;                 //  Number of PLACEs in PLACES.
+int       placesLimit;                  //  Room for PLACEs in PLACES.
 refObject plainLayer;                   //  An empty plain layer.
 set       postfixSet;                   //  Set of postfix operator tokens.
+bool      prettying;                    //  Are we filling lines of C code?
+refObject procedures;                   //  Names of all PROCs.
 refObject proJoker;                     //  All PROC types.
 int       programCount;                 //  Unique number of current PROGram.
 refObject real0Simple;                  //  The simple type REAL0.
 refObject real1Simple;                  //  The simple type REAL1.
 refObject rejJoker;                     //  All REAL types.
 refObject realZero;                     //  The real 0.0.
+double    reclaimTime;                  //  Seconds spent reclaiming HUNKs.
 refObject resultName;                   //  The value returned by C code.
 refObject rightBracesName;              //  The name " {}".
 refObject rightBracketsName;            //  The name " []".
@@ -1574,6 +1711,7 @@ refObject rowRowChar0;                  //  The type ROW ROW CHAR0.
 refObject rowVoid;                      //  The type ROW VOID.
 refObject rowVoidExternal;              //  The C type (VOID *).
 set       semicolonSet;                 //  Set of the ";" token.
+int       sizedCount;                   //  Count calls to RECLAIM SIZED HUNKS.
 refHunk   sizedHunks[maxHunkSize + 1];  //  Lists of sized free HUNKs.
 refSize   sizes;                        //  BST that holds type sizes.
 refObject skolemLayer;                  //  An empty Skolem layer.
@@ -1585,8 +1723,13 @@ refBuffer target;                       //  Buffer for C target output.
 refChar   targetPath;                   //  Path to file receiving GCC code.
 set       termSet;                      //  Tokens that start a term.
 refObject toBool[2];                    //  Turn C's bools into Orson's bools.
-refObject topName;                      //  Name of the top mark frame.
+bool      threading;                    //  Are thread variables local?
+refObject threadNames;                  //  Names of thread local variables.
+refObject topName;                      //  Name of the top of the mark frames.
 refObject tossed;                       //  An ignored object.
+refChar   tracePath;                    //  Write TRACEs here, or NIL.
+refTrace  traces;                       //  Root of the tree of TRACEs.
+long      transformCount;               //  Count calls to TRANSFORM.
 refObject typeExeJoker;                 //  The type of EXE JOKER.
 refObject typeFojJoker;                 //  The type of FOJ JOKER.
 refObject typeMutJoker;                 //  The type of MUT JOKER.
@@ -1596,6 +1739,7 @@ refObject typeTypeObjJoker;             //  The type of TYPE OBJ JOKER.
 refObject typeTypeVoid;                 //  The type of TYPE VOID.
 refObject typeVoid;                     //  The type of VOID.
 set       unitSet;                      //  Tokens that start a unit.
+int       unsizedCount;                 //  Count RECLAIM UNSIZED HUNKS calls.
 hunk      unsizedHunks;                 //  List of unsized free HUNKs.
 bool      usePrelude;                   //  Will we load a prelude file?
 set       userErrs;                     //  Errors assertable by user code.
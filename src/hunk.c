@@ -55,9 +55,14 @@ void initHunk()
   refHeap nextHeap;
   refHunk nextHunk;
 
-//  Initialize the frame stack and the free lists.
+//  Initialize the frame stack, the free lists, and what we measure about them.
 
   frames = nil;
+  liveBytes = 0;
+  peakBytes = 0;
+  reclaimTime = 0.0;
+  sizedCount = 0;
+  unsizedCount = 0;
   unsizedHunks.next = nil;
   for (index = 0; index <= maxHunkSize; index += 1)
   { sizedHunks[index] = nil; }
@@ -139,36 +144,43 @@ void mark(refObject object)
 void reclaimSizedHunks()
 { int          count;
   refHunk      lastHunk;
+  long         live;
   refHeap      nextHeap;
   refHunk      nextHunk;
   refFrame     nextFrame;
   refRefObject refsStart;
   int          size;
+  double       start;
   int          total;
 
 //  Mark protected global variables.
 
+  sizedCount += 1;
+  start = traceTime();
   mark(bases);
   mark(cellSimple);
   mark(characterZero);
-  mark(countName);
+  mark(collectors);
+  mark(definitions);
   mark(emptyAlts);
   mark(emptyClosure);
   mark(emptyString);
   mark(fakeCall);
+  mark(firstDefinition);
   mark(firstProc);
   mark(formCall);
   mark(integerOne);
   mark(integerMinusOne);
   mark(integerZero);
+  mark(lastDefinition);
   mark(lastProc);
   mark(layers);
-  mark(linkName);
   mark(markable);
   mark(markingName);
   mark(toRefObject(matches));
   mark(nullSimple);
   mark(plainLayer);
+  mark(procedures);
   mark(realZero);
   mark(resultName);
   mark(rowChar0);
@@ -177,6 +189,7 @@ void reclaimSizedHunks()
   mark(rowVoidExternal);
   mark(skolemLayer);
   mark(symNoName);
+  mark(threadNames);
   mark(typeExeJoker);
   mark(typeFojJoker);
   mark(typeMutJoker);
@@ -205,8 +218,9 @@ void reclaimSizedHunks()
 //  list somewhere. If we find a marked hunk, then we simply unmark it, because
 //  it's still in use. If we find an unmarked hunk, then it's not in use, so we
 //  reset its TAG to HUNK TAG, and add it to the appropriate free list in SIZED
-//  HUNKS.
+//  HUNKS. The marked hunks are the only ones still in use.
 
+  live = 0;
   total = 0;
   nextHeap = heaps;
   while (nextHeap != nil)
@@ -224,9 +238,12 @@ void reclaimSizedHunks()
           sizedHunks[size] = nextHunk;
           total += size; }
         else
-        { state(nextHunk) = 0; }
+        { state(nextHunk) = 0;
+          live += size; }
         nextHunk = toRefHunk(toRefChar(nextHunk) + size); }}
     nextHeap = next(nextHeap); }
+  liveBytes = live;
+  reclaimTime += traceTime() - start;
 
 //  Write optional debugging information.
 
@@ -245,9 +262,12 @@ void reclaimUnsizedHunks()
   refHunk nextHunk;
   refHunk rightHunk;
   int     size;
+  double  start;
 
 //  Clobber the sized free lists.
 
+  unsizedCount += 1;
+  start = traceTime();
   for (size = 0; size <= maxHunkSize; size += 1)
   { sizedHunks[size] = nil; }
 
@@ -289,7 +309,8 @@ void reclaimUnsizedHunks()
       { size = size(nextHunk); }
       nextHunk = toRefHunk(toRefChar(nextHunk) + size); }
     nextHeap = next(nextHeap); }
-  next(newHunk) = nil; }
+  next(newHunk) = nil;
+  reclaimTime += traceTime() - start; }
 
 //  MAKE HUNK. Return a pointer to a new hunk of SIZE bytes, using a version of
 //  the Weinstock-Wulf "Quick Fit" allocator. See:
@@ -309,6 +330,10 @@ refVoid makeHunk(int size)
 
 //  Try to satisfy the request from SIZED HUNKS. This works most of the time.
 
+  hunkBytes += size;
+  liveBytes += size;
+  if (liveBytes > peakBytes)
+  { peakBytes = liveBytes; }
   newHunk = sizedHunks[size];
   if (newHunk != nil)
   { sizedHunks[size] = next(newHunk);
@@ -340,9 +365,11 @@ refVoid makeHunk(int size)
          { leftHunk = rightHunk;
            rightHunk = next(rightHunk); }}
 
-//  If that didn't work, then collect garbage and try SIZED HUNKS again.
+//  If that didn't work, then collect garbage and try SIZED HUNKS again. The GC
+//  counted only the hunks that were marked, so we must count this one again.
 
   reclaimSizedHunks();
+  liveBytes += size;
   newHunk = sizedHunks[size];
   if (newHunk != nil)
   { sizedHunks[size] = next(newHunk);
@@ -392,6 +419,7 @@ refVoid makeHunk(int size)
 void destroy(refVoid object)
 { refHunk hunk = toRefHunk(object);
   int size = size(hunk);
+  liveBytes -= size;
   tag(hunk) = hunkTag;
   space(hunk) = size;
   next(hunk) = sizedHunks[size];
@@ -469,6 +469,7 @@ void loadOrson(refChar path, refStream source, bool allowHooks)
   refInt  lineEnd;                     //  End of LINE.
   refInt  lineStart;                   //  Start of LINE.
   int     oldCharCount;                //  Save previous CHAR COUNT here.
+  refFile sourceFile;                  //  Records SOURCE's path and lines.
   int     token;                       //  Most recent token from SOURCE.
   int     tokenCount;                  //  Position of TOKEN in SOURCE.
   bool    tokenEndsTerm;               //  Might TOKEN end a term?
@@ -497,11 +498,13 @@ void loadOrson(refChar path, refStream source, bool allowHooks)
 //  feed char, and R is the ASCII return char, then a line may be terminated by
 //  L, R, L R, or R L. The last line in SOURCE may also be terminated by an EOF
 //  CHAR. The end of SOURCE is signaled by a line containing a lone EOP CHAR.
+//  We record where each LINE starts, so errors in it can be written later.
 
   void nextLine()
   { int temp;
     lineEnd = line;
     lineStart = line;
+    startsLine(sourceFile, charCount, ftell(source));
     while (true)
     { temp = getChar(source);
       switch (temp)
@@ -524,7 +527,7 @@ void loadOrson(refChar path, refStream source, bool allowHooks)
           d(lineEnd) = eosChar;
           return; }
         default:
-        { if (lineEnd < line + maxLineLength + 1)
+        { if (lineEnd < line + maxLineLength - 1)
           { if (isIllegalChar(temp))
             { lineError(illegalCharErr);
               d(lineEnd) = ' '; }
@@ -2635,7 +2638,7 @@ void loadOrson(refChar path, refStream source, bool allowHooks)
   push(f0, 4);
   oldCharCount = charCount;
   charCount = makeCharCount();
-  wasLoaded(path, charCount);
+  sourceFile = wasLoaded(path, charCount);
   tokenEndsTerm = false;
   nextLine();
   nextChar();
@@ -2663,7 +2666,9 @@ void loadOrson(refChar path, refStream source, bool allowHooks)
           transform(toss, r(f0.value), f0.first);
           break; }
 
-//  Parse and transform a PROG clause.
+//  Parse and transform a PROG clause. If there are no errors, then optimize it
+//  and write it as C code. PROGs may be nested in LOADs, so we add how long
+//  each of those took to OPTIMIZE TIME and EMIT TIME here, for the -b option.
 
         case boldProgToken:
         { programCount += 1;
@@ -2681,7 +2686,14 @@ void loadOrson(refChar path, refStream source, bool allowHooks)
           nextExpected(closeParenToken, closeParenErr);
           transform(toss, r(f0.value), f0.first);
           if (isSetEmpty(allErrs))
-          { emitProgram(f0.value); }
+          { double start = traceTime();
+            double middle;
+            optimize(f0.value);
+            elideFrames(f0.value);
+            middle = traceTime();
+            emitProgram(f0.value);
+            optimizeTime += middle - start;
+            emitTime += traceTime() - middle; }
           break; }
 
 //  Parse and transform something not a LOAD clause or a PROG clause. We assume
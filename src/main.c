@@ -23,10 +23,20 @@
 //  MAIN. Main program. Initialize, translate, maybe compile.
 
 int main(int count, refRefChar strings)
-{ bool      compiling;            //  Will we compile the C target file?
+{ bool      benching;             //  Will we write what each phase cost?
+  double    compileTime;          //  Seconds spent compiling the C target.
+  bool      compiling;            //  Will we compile the C target file?
+  double    lapTime;              //  When the current phase started.
+  double    mainTime;             //  Seconds spent writing C's MAIN.
   char      path[maxPathLength];  //  An absolute pathname.
+  bool      piping;               //  Will we keep the C target in memory?
+  double    preludeTime;          //  Seconds spent loading the prelude.
   set       seen;                 //  Command line options seen so far.
   refStream source;               //  Read source files through this.
+  double    spentTime;            //  Seconds in other phases at last LAP.
+  refChar   text;                 //  The C target, if it's in memory.
+  size_t    textLength;           //  Number of chars in TEXT.
+  double    transformTime;        //  Seconds spent loading source files.
   bool      who;                  //  Did the user ask who we are?
 
 //  STRING OPTION. Return the string value of OPTION. It's either the string on
@@ -57,21 +67,92 @@ int main(int count, refRefChar strings)
     { return number; }}
 
 //  UNTARGET. Try to close the target stream and try to remove the target file.
-//  Each call to UNTARGET is followed by a call to EXIT or FAIL.
+//  If the target is in memory, then there's no file to remove. Each call to
+//  UNTARGET is followed by a call to EXIT or FAIL.
 
   void untarget()
-  { if (fclose(stream(target)) != 0)
-    { fprintf(stderr, "%s: Cannot close file '%s'.\n", me, targetPath); }
-    if (unlink(targetPath) != 0)
-    { fprintf(stderr, "%s: Cannot remove file '%s'.\n", me, targetPath); }}
+  { if (piping)
+    { fclose(stream(target)); }
+    else
+    { if (fclose(stream(target)) != 0)
+      { fprintf(stderr, "%s: Cannot close file '%s'.\n", me, targetPath); }
+      if (unlink(targetPath) != 0)
+      { fprintf(stderr, "%s: Cannot remove file '%s'.\n", me, targetPath); }}}
+
+//  UNPIPE. Write TEXT, the C target in memory, to a pipe that runs COMMAND,
+//  and return the pipe's exit status. If COMMAND is NIL, then write TEXT to
+//  STDOUT instead.
+
+  int unpipe(refChar command)
+  { refStream stream;
+    if (command == nil)
+    { stream = stdout; }
+    else
+    { stream = popen(command, "w");
+      if (stream == nil)
+      { fail("Cannot run '%s'.", command); }}
+    if (fwrite(text, 1, textLength, stream) != textLength)
+    { fail("Cannot write GNU C code."); }
+    free(text);
+    if (command == nil)
+    { return fflush(stream); }
+    else
+    { return pclose(stream); }}
+
+//  LAP. Return how many seconds have passed since the last call to LAP, which
+//  ended the previous phase and started the current one. PROGs are optimized
+//  and written as C code while they're loaded, so we don't count the seconds
+//  that were added to OPTIMIZE TIME and EMIT TIME since then.
+
+  double lap()
+  { double time = traceTime();
+    double spent = optimizeTime + emitTime;
+    double seconds = time - lapTime - (spent - spentTime);
+    lapTime = time;
+    spentTime = spent;
+    return seconds; }
+
+//  WRITE PHASES. If we're benching, then write to DEBUG how long each phase
+//  took, and what it cost to manage the heap. Each line has a number, then the
+//  name of what it measures, so scripts can read it.
+
+  void writePhases()
+  { if (benching)
+    { fprintf(stream(debug), "%12s  %s\n", "value", "measure");
+      fprintf(stream(debug), "%12.3f  %s\n",
+       preludeTime * 1000.0, "prelude msec");
+      fprintf(stream(debug), "%12.3f  %s\n",
+       transformTime * 1000.0, "transform msec");
+      fprintf(stream(debug), "%12.3f  %s\n",
+       optimizeTime * 1000.0, "optimize msec");
+      fprintf(stream(debug), "%12.3f  %s\n",
+       (emitTime + mainTime) * 1000.0, "emit msec");
+      fprintf(stream(debug), "%12.3f  %s\n",
+       compileTime * 1000.0, "compile msec");
+      fprintf(stream(debug), "%12.3f  %s\n",
+       reclaimTime * 1000.0, "reclaim msec");
+      fprintf(stream(debug), "%12i  %s\n", sizedCount, "sized reclaims");
+      fprintf(stream(debug), "%12i  %s\n", unsizedCount, "unsized reclaims");
+      fprintf(stream(debug), "%12li  %s\n", transformCount, "transforms");
+      fprintf(stream(debug), "%12li  %s\n", hunkBytes, "made bytes");
+      fprintf(stream(debug), "%12li  %s\n", peakBytes, "peak bytes");
+      fprintf(stream(debug), "%12li  %s\n",
+       heapCount * (long) sizeof(heap), "heap bytes"); }}
 
 //  Default values of command line options.
 
   asciiing      = false;               //  Option -a. (ASCII.)
+  benching      = false;               //  Option -b. (Benchmark.)
   compiling     = true;                //  Option -t. (Translate.)
+  maxCostCount  = 0;                   //  Option -c. (Cost.)
   maxDebugLevel = -1;                  //  Option -d. (Debug.)
+  tracePath     = nil;                 //  Option -f. (Flame.)
   heapCount     = 2;                   //  Option -h. (Heap.)
+  jsoning       = false;               //  Option -j. (JSON.)
+  threading     = false;               //  Option -l. (Local.)
+  piping        = false;               //  Option -m. (Memory.)
   targetPath    = targetFile cSource;  //  Option -o. (Output.)
+  prettying     = false;               //  Option -p. (Pretty.)
   maxLevel      = 1024;                //  Option -s. (Stack.)
   usePrelude    = true;                //  Option -r. (Raw.)
   who           = false;               //  Option -v. (Version.)
@@ -89,10 +170,18 @@ int main(int count, refRefChar strings)
     { switch (d(string))
       { case eosChar:
         { fail("Unknown option '-'."); }
+        case 'c':
+        { maxCostCount = intOption(string, 0, maxInt);
+          seen = setAdjoin(seen, 'c');
+          break; }
         case 'd':
         { maxDebugLevel = intOption(string, 0, maxInt);
           seen = setAdjoin(seen, 'd');
           break; }
+        case 'f':
+        { tracePath = stringOption(string);
+          seen = setAdjoin(seen, 'f');
+          break; }
         case 'h':
         { heapCount = intOption(string, 1, maxInt);
           seen = setAdjoin(seen, 'h');
@@ -115,6 +204,26 @@ int main(int count, refRefChar strings)
                 { asciiing = true;
                   seen = setAdjoin(seen, 'a');
                   break; }
+                case 'b':
+                { benching = true;
+                  seen = setAdjoin(seen, 'b');
+                  break; }
+                case 'j':
+                { jsoning = true;
+                  seen = setAdjoin(seen, 'j');
+                  break; }
+                case 'l':
+                { threading = true;
+                  seen = setAdjoin(seen, 'l');
+                  break; }
+                case 'm':
+                { piping = true;
+                  seen = setAdjoin(seen, 'm');
+                  break; }
+                case 'p':
+                { prettying = true;
+                  seen = setAdjoin(seen, 'p');
+                  break; }
                 case 'r':
                 { usePrelude = false;
                   seen = setAdjoin(seen, 'r');
@@ -144,6 +253,7 @@ int main(int count, refRefChar strings)
 
   if (count > 0)
   { initBuffer();
+    initCost();
     initError();
     initFile();
     initHunk();
@@ -154,24 +264,45 @@ int main(int count, refRefChar strings)
     initPrelude();
     initSize();
     initSubtype();
+    initTrace();
     initTransform();
+    initOptimize();
     initEmit();
     initExpression();
     initStatement();
+    compileTime   = 0.0;
+    mainTime      = 0.0;
+    preludeTime   = 0.0;
+    spentTime     = 0.0;
+    transformTime = 0.0;
+    lapTime       = traceTime();
 
-//  Open a target file to receive translated C code.
+//  Open a target file to receive translated C code. If we're piping, then the
+//  target is a stream that writes to memory instead.
 
-    stream(target) = fopen(targetPath, "w");
-    if (stream(target) == nil)
-    { fail("Cannot open file '%s'.", targetPath); }
+    if (piping)
+    { stream(target) = open_memstream(r(text), r(textLength));
+      if (stream(target) == nil)
+      { fail("Cannot open a stream to memory."); }}
     else
-    { writeHerald(stream(target)); }
+    { stream(target) = fopen(targetPath, "w");
+      if (stream(target) == nil)
+      { fail("Cannot open file '%s'.", targetPath); }}
+    writeHerald(stream(target));
+
+//  Open a stream to memory that receives C code for PROCs. Only the code for
+//  PROCs that are reached will be copied to the target (see ORSON/PROGRAM).
+
+    stream(deferred) = open_memstream(r(deferredText), r(deferredLength));
+    if (stream(deferred) == nil)
+    { fail("Cannot open a stream to memory."); }
 
 //  If nothing awful happened during translation (so we didn't LONGJMP to HALT)
 //  then maybe search for a prelude file, and translate it to C if we find it.
 
     if (setjmp(halt) == 0)
-    { if (usePrelude)
+    { lap();
+      if (usePrelude)
       { source = openPortablePath(path, "lib.prelude:op");
         if (source == nil)
         { untarget();
@@ -185,6 +316,7 @@ int main(int count, refRefChar strings)
           if (fclose(source) != 0)
           { untarget();
             fail("Cannot close file '%s'.", path); }}}
+      preludeTime = lap();
 
 //  Translate the files named on the command line to C. This is equivalent to a
 //  series of LOAD clauses in which the file names appear.
@@ -215,21 +347,47 @@ int main(int count, refRefChar strings)
             { untarget();
               fail("Cannot close file '%s'", path); }}}
         count -= 1; strings += 1; }
+      transformTime = lap();
 
+//  Maybe write what it cost to transform PROCs, and to call hooks and forms.
 //  If there are no errors, then close the target file, maybe compile it, maybe
-//  remove it, and exit. Otherwise maybe write errors, clean up, and exit.
+//  remove it, maybe write what each phase cost, and exit. If we're piping,
+//  then there's no file: we pipe the C code in memory to GCC, or to STDOUT if
+//  we're not compiling. Otherwise maybe write errors, clean up, and exit.
 
+      if (maxCostCount > 0)
+      { writeCosts(); }
+      if (tracePath != nil)
+      { writeTraces(); }
       if (isSetEmpty(allErrs))
-      { emitMain();
+      { lap();
+        emitMain();
         if (fclose(stream(target)) == 0)
-        { if (compiling)
-          { char temp[strlen(compiler) + strlen(targetPath) + 1];
-            int status = system(strcat(strcpy(temp, compiler), targetPath));
-            if (unlink(targetPath) != 0)
-            { fail("Cannot remove file '%s'.", targetPath); }
+        { mainTime = lap();
+          if (piping)
+          { int status =
+             unpipe(compiling
+              ? (threading ? compiler pthreads fromStdin : compiler fromStdin)
+              : nil);
+            compileTime = lap();
+            writePhases();
             exit(status != 0); }
-          else
-          { exit(0); }}
+          else if (compiling)
+               { char temp[
+                  strlen(compiler) + strlen(pthreads) + strlen(targetPath) + 1];
+                 int status;
+                 strcpy(temp, compiler);
+                 if (threading)
+                 { strcat(temp, pthreads); }
+                 status = system(strcat(temp, targetPath));
+                 compileTime = lap();
+                 if (unlink(targetPath) != 0)
+                 { fail("Cannot remove file '%s'.", targetPath); }
+                 writePhases();
+                 exit(status != 0); }
+               else
+               { writePhases();
+                 exit(0); }}
         else
         { untarget();
           exit(1); }}
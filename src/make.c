@@ -41,19 +41,26 @@ refBinder makeBinder(refObject key, refObject info, refObject value)
   count(newBinder)  = -1;
   return newBinder; }
 
-//  MAKE BUFFER. Return a new empty BUFFER that writes to STREAM. Every line it
-//  writes will be at most MAX BUFFER LENGTH chars long. The first INDENT chars
-//  on each line will be blanks.
+//  MAKE BUFFER. Return a new empty BUFFER that writes to STREAM. If FILLING is
+//  TRUE, then every line it writes will be at most MAX BUFFER LENGTH chars,
+//  and the first INDENT chars on each line will be blanks. Its block starts
+//  with BLOCK SIZE chars, holding the blanks for its first line.
 
-refBuffer makeBuffer(refStream stream, int indent)
+refBuffer makeBuffer(refStream stream, int indent, bool filling)
 { refBuffer newBuffer = malloc(bufferSize);
-  if (newBuffer == nil)
+  refChar newStart = malloc(blockSize);
+  if (newBuffer == nil || newStart == nil)
   { fail("Cannot make a buffer in makeBuffer!"); }
   else
-  { end(newBuffer) = start(newBuffer);
-    indent(newBuffer) = indent;
-    length(newBuffer) = maxBufferLength - indent;
-    stream(newBuffer) = stream;
+  { memset(newStart, ' ', indent);
+    filling(newBuffer) = filling;
+    indent(newBuffer)  = indent;
+    length(newBuffer)  = maxBufferLength - indent;
+    limit(newBuffer)   = newStart + blockSize;
+    line(newBuffer)    = newStart + indent;
+    end(newBuffer)     = line(newBuffer);
+    start(newBuffer)   = newStart;
+    stream(newBuffer)  = stream;
     return newBuffer; }}
 
 //  MAKE CELL. Return a new CELL that holds TYPE and VALUE.
@@ -90,6 +97,22 @@ refObject makeInteger(int self)
   self(newInteger)    = self;
   return toRefObject(newInteger); }
 
+//  MAKE COST. Return a new COST for PROC bodies whose char count is COUNT. It
+//  says they haven't cost anything yet.
+
+refCost makeCost(int count)
+{ refCost newCost = malloc(costSize);
+  if (newCost == nil)
+  { fail("Cannot make a cost in makeCost!"); }
+  else
+  { bytes(newCost)      = 0;
+    count(newCost)      = count;
+    duration(newCost)   = 0.0;
+    next(newCost)       = nil;
+    procs(newCost)      = 0;
+    transforms(newCost) = 0; }
+  return newCost; }
+
 //  MAKE FILE. Return a new FILE that holds COUNT and a copy of PATH.
 
 refFile makeFile(refChar path, int count)
@@ -98,9 +121,12 @@ refFile makeFile(refChar path, int count)
   if (newFile == nil || newPath == nil)
   { fail("Cannot make a file for '%s' in makeFile!", path); }
   else
-  { count(newFile) = count;
-    path(newFile)  = strcpy(newPath, path);
-    next(newFile)  = nil; }
+  { count(newFile)  = count;
+    length(newFile) = 0;
+    limit(newFile)  = 0;
+    path(newFile)   = strcpy(newPath, path);
+    spots(newFile)  = nil;
+    next(newFile)   = nil; }
   return newFile; }
 
 //  MAKING JOKER. Return a new JOKER, named STRING. It contains the hooks given
@@ -188,19 +214,6 @@ refObject makePaire(refObject car, refObject cdr, int info)
   info(newPair)   = info;
   return toRefObject(newPair); }
 
-//  MAKE PLACE. Return a new PLACE which holds COUNT, a set containing ERR, and
-//  NEXT.
-
-refPlace makePlace(int count, int err, refPlace next)
-{ refPlace newPlace = malloc(placeSize);
-  if (newPlace == nil)
-  { fail("Cannot make a place for %i in makePlace!", count); }
-  else
-  { count(newPlace) = count;
-    errs(newPlace)  = makeSet(err);
-    next(newPlace)  = next;
-    return newPlace; }}
-
 //  MAKE REAL. Return a new REAL that holds SELF.
 
 refObject makeReal(double self)
@@ -233,6 +246,8 @@ refSnip makeSnip()
   size(newSnip)   = snipSize;
   state(newSnip)  = 0;
   tag(newSnip)    = snipTag;
+  count(newSnip)  = 0;
+  chars(newSnip)  = 0;
   next(newSnip)   = nil;
   memset(self(newSnip), eosChar, maxSnipLength);
   return newSnip; }
@@ -246,6 +261,7 @@ refString makeString()
   state(newString)  = 0;
   tag(newString)    = stringTag;
   first(newString)  = nil;
+  last(newString)   = nil;
   bytes(newString)  = 0;
   chars(newString)  = 0;
   return newString; }
@@ -267,6 +283,26 @@ refObject makeStub(refObject name)
   { string(newStub) = string(toRefName(name)); }
   return toRefObject(newStub); }
 
+//  MAKE TRACE. Return a new TRACE with KEY and STRING. It's the first child of
+//  PARENT, but PARENT doesn't know that yet.
+
+refTrace makeTrace(int key, refChar string, refTrace parent)
+{ refTrace newTrace = malloc(traceSize);
+  if (newTrace == nil)
+  { fail("Cannot make a trace in makeTrace!"); }
+  else
+  { calls(newTrace)     = 0;
+    children(newTrace)  = 0.0;
+    exclusive(newTrace) = 0.0;
+    inclusive(newTrace) = 0.0;
+    key(newTrace)       = key;
+    start(newTrace)     = 0.0;
+    string(newTrace)    = string;
+    child(newTrace)     = nil;
+    next(newTrace)      = (parent == nil ? nil : child(parent));
+    parent(newTrace)    = parent; }
+  return newTrace; }
+
 //  MAKE TRIPLE. Return a new TRIPLE that holds CAR, CDR, and INFO.
 
 refObject makeTriple(refObject car, refObject cdr, refObject info)
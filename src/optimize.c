@@ -0,0 +1,906 @@
+//
+//  ORSON/OPTIMIZE. Simplify transformed terms before translating them to C.
+//
+//  Copyright (C) 2012 James B. Moen.
+//
+//  This program  is free  software: you can  redistribute it and/or  modify it
+//  under the terms of the  GNU General Public License as published by the Free
+//  Software Foundation, either  version 3 of the License,  or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY  WARRANTY; without  even  the implied  warranty  of MERCHANTABILITY  or
+//  FITNESS FOR A  PARTICULAR PURPOSE.  See the GNU  General Public License for
+//  more details.
+//
+//  You should  have received a  copy of the  GNU General Public  License along
+//  with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "global.h"
+
+//  TRANSFORM folds constants one hook at a time, as it makes each term. It can
+//  not see that a variable in a WITH is never changed, so its initial constant
+//  value could be used instead. It also can't see when two terms have the same
+//  value. We do those things here, then fold again the terms they affect.
+
+//  INIT OPTIMIZE. Initialize globals.
+
+void initOptimize()
+{ baseName     = internSecretName("FrameBase");
+  collectors   = pushLayer(nil, plainInfo);
+  optimizeTime = 0.0;
+  procedures   = pushLayer(nil, plainInfo); }
+
+//  ELIDE FRAMES. Remove mark frames from WITH clauses in the transformed PROG
+//  term TERM, if the garbage collector can't run while they're active. Then a
+//  WITH's markable variables become ordinary C variables, which GCC may keep
+//  in registers, and we don't push or pop a frame for them.
+//
+//  The garbage collector can run only if something reads FRAME BASE, where the
+//  current thread's stack of base pointers starts. Code that lets another
+//  thread collect garbage while this one waits must read it too. We find each
+//  PROC that might do that, or might call another PROC that does, and remember
+//  its name in the layer COLLECTORS. PROCs from earlier PROG terms are already
+//  there, and every PROC is bound in PROCEDURES. If we can't tell which PROC
+//  is called, then we assume it might collect garbage.
+
+void elideFrames(refObject term)
+{ bool changing;
+  struct
+  { refFrame  link;
+    int       count;
+    refObject elided;
+    refObject names;
+    refObject next;
+    refObject visitor;
+    refObject walker; } f;
+
+//  Mutual recursions among local functions.
+
+  auto bool isCollecting(refObject);
+
+//  IS COLLECTING LIST. Test if some term in the list TERMS might collect.
+
+  bool isCollectingList(refObject terms)
+  { while (terms != nil)
+    { if (isCollecting(car(terms)))
+      { return true; }
+      else
+      { terms = cdr(terms); }}
+    return false; }
+
+//  IS COLLECTING. Test if TERM might call the garbage collector. We use
+//  VISITOR to avoid going through the same pair twice. We never visit type
+//  terms.
+
+  bool isCollecting(refObject term)
+  { if (term == nil)
+    { return false; }
+    else if (isName(term))
+         { return term == baseName || gotKey(toss, toss, collectors, term); }
+         else if (! isPair(term) || gotKey(toss, toss, f.visitor, term))
+              { return false; }
+              else
+              { setKey(f.visitor, term, nil, nil);
+                switch (toHook(car(term)))
+                { case applyHook:
+                  { if (isCar(cadr(term), closeHook)
+                     || (isName(cadr(term))
+                      && gotKey(toss, toss, procedures, cadr(term))))
+                    { return isCollectingList(cdr(term)); }
+                    else
+                    { return true; }}
+                  case caseHook:
+                  { term = cdr(term);
+                    if (isCollecting(car(term)))
+                    { return true; }
+                    else
+                    { term = cdr(term);
+                      while (cdr(term) != nil)
+                      { term = cdr(term);
+                        if (isCollecting(car(term)))
+                        { return true; }
+                        else
+                        { term = cdr(term); }}
+                      return isCollecting(car(term)); }}
+                  case charCastHook:
+                  case intCastHook:
+                  case realCastHook:
+                  case rowCastHook:
+                  { return isCollecting(caddr(term)); }
+                  case closeHook:
+                  { return
+                     cdr(term) != nil && isCollecting(car(cadddr(term))); }
+                  case rowToHook:
+                  case varToHook:
+                  { return isCollecting(cadr(term)); }
+                  case slotHook:
+                  { return false; }
+                  case withHook:
+                  { term = cddr(term);
+                    while (cdr(term) != nil)
+                    { if (caddr(term) != nil
+                       && ! isProcEquate(car(term), caddr(term))
+                       && isCollecting(caddr(term)))
+                      { return true; }
+                      else
+                      { term = cdddr(term); }}
+                    return isCollecting(car(term)); }
+                  default:
+                  { return isCollectingList(cdr(term)); }}}}
+
+//  IS COLLECTING PROC. Test if the PROC closure CLOSE might collect garbage.
+
+  bool isCollectingProc(refObject close)
+  { bool found;
+    f.visitor = pushLayer(nil, plainInfo);
+    found = cdr(close) != nil && isCollecting(car(cadddr(close)));
+    destroyLayer(f.visitor);
+    f.visitor = nil;
+    return found; }
+
+//  VISITING. Call VISIT on each pair in TERM, and then visit its subterms. We
+//  use WALKER to avoid going through the same pair twice. We never visit type
+//  terms.
+
+  void visiting(refObject term, void visit(refObject))
+  { if (term != nil && isPair(term) && ! gotKey(toss, toss, f.walker, term))
+    { setKey(f.walker, term, nil, nil);
+      visit(term);
+      switch (toHook(car(term)))
+      { case caseHook:
+        { term = cdr(term);
+          visiting(car(term), visit);
+          term = cdr(term);
+          while (cdr(term) != nil)
+          { term = cdr(term);
+            visiting(car(term), visit);
+            term = cdr(term); }
+          visiting(car(term), visit);
+          break; }
+        case charCastHook:
+        case intCastHook:
+        case realCastHook:
+        case rowCastHook:
+        { visiting(caddr(term), visit);
+          break; }
+        case closeHook:
+        { if (cdr(term) != nil)
+          { visiting(car(cadddr(term)), visit); }
+          break; }
+        case rowToHook:
+        case varToHook:
+        { visiting(cadr(term), visit);
+          break; }
+        case slotHook:
+        { break; }
+        case withHook:
+        { term = cddr(term);
+          while (cdr(term) != nil)
+          { visiting(caddr(term), visit);
+            term = cdddr(term); }
+          visiting(car(term), visit);
+          break; }
+        default:
+        { term = cdr(term);
+          while (term != nil)
+          { visiting(car(term), visit);
+            term = cdr(term); }
+          break; }}}}
+
+//  GATHERING. If TERM is a WITH, then add the names and values of its PROCs to
+//  NAMES, and bind them in PROCEDURES.
+
+  void gathering(refObject term)
+  { if (isCar(term, withHook))
+    { term = cddr(term);
+      while (cdr(term) != nil)
+      { if (caddr(term) != nil && isProcEquate(car(term), caddr(term)))
+        { f.names = makePair(caddr(term), f.names);
+          f.names = makePair(cadr(term), f.names);
+          setKey(procedures, cadr(term), nil, caddr(term)); }
+        term = cdddr(term); }}}
+
+//  ELIDING. If TERM is a WITH with a frame, and it can't collect garbage, then
+//  remove its frame, and remember that we did in ELIDED. If TERM is a SLOT in
+//  a frame we removed, then remove the frame from the SLOT too, so it becomes
+//  an ordinary C variable.
+
+  void eliding(refObject term)
+  { if (isCar(term, withHook) && cadr(term) != nil)
+    { f.visitor = pushLayer(nil, plainInfo);
+      if (! isCollecting(term))
+      { setKey(f.elided, cadr(term), nil, nil);
+        car(cdr(term)) = nil; }
+      destroyLayer(f.visitor);
+      f.visitor = nil; }
+    else if (isCar(term, slotHook)
+          && cadr(term) != nil
+          && gotKey(toss, toss, f.elided, cadr(term)))
+         { car(cdr(term)) = nil; }}
+
+//  Find the PROCs in the equates of TERM, including those nested inside other
+//  PROCs.
+
+  push(f, 5);
+  f.elided = pushLayer(nil, plainInfo);
+  f.walker = pushLayer(nil, plainInfo);
+  term = cddr(term);
+  f.next = term;
+  while (f.next != nil && cdr(f.next) != nil)
+  { if (caddr(f.next) != nil && isProcEquate(car(f.next), caddr(f.next)))
+    { f.names = makePair(caddr(f.next), f.names);
+      f.names = makePair(cadr(f.next), f.names);
+      setKey(procedures, cadr(f.next), nil, caddr(f.next)); }
+    visiting(caddr(f.next), gathering);
+    f.next = cdddr(f.next); }
+
+//  Add PROCs that might collect garbage to COLLECTORS, until there are no more
+//  to add. A PROC might call one that comes later, so we may need many passes.
+
+  do
+  { changing = false;
+    f.next = f.names;
+    while (f.next != nil)
+    { if (! gotKey(toss, toss, collectors, car(f.next))
+       && isCollectingProc(cadr(f.next)))
+      { setKey(collectors, car(f.next), nil, nil);
+        changing = true; }
+      f.next = cddr(f.next); }}
+  while (changing);
+
+//  Remove the frames that we don't need. The PROG's own frame holds its global
+//  variables, so it's always needed.
+
+  destroyLayer(f.walker);
+  f.walker = pushLayer(nil, plainInfo);
+  f.next = term;
+  while (f.next != nil && cdr(f.next) != nil)
+  { visiting(caddr(f.next), eliding);
+    f.next = cdddr(f.next); }
+  pop();
+  destroyLayer(f.elided);
+  destroyLayer(f.walker); }
+
+//  IS BOOLEAN. Test if TERM always returns either 0 or 1.
+
+bool isBoolean(refObject term)
+{ if (term == nil)
+  { return false; }
+  else if (isInteger(term))
+       { return toInteger(term) == 0 || toInteger(term) == 1; }
+       else if (isPair(term))
+            { switch (toHook(car(term)))
+              { case charEqHook:
+                case charGeHook:
+                case charGtHook:
+                case charLeHook:
+                case charLtHook:
+                case charNeHook:
+                case intEqHook:
+                case intGeHook:
+                case intGtHook:
+                case intLeHook:
+                case intLtHook:
+                case intNeHook:
+                case notHook:
+                case realEqHook:
+                case realGeHook:
+                case realGtHook:
+                case realLeHook:
+                case realLtHook:
+                case realNeHook:
+                case rowEqHook:
+                case rowGeHook:
+                case rowGtHook:
+                case rowLeHook:
+                case rowLtHook:
+                case rowNeHook:
+                { return true; }
+                case andHook:
+                case orHook:
+                { return isBoolean(cadr(term)) && isBoolean(caddr(term)); }
+                default:
+                { return false; }}}
+            else
+            { return false; }}
+
+//  IS SAME TERM. Test if LEFT and RIGHT are terms that always return the same
+//  value, because they're made from the same constants, names, and hooks. This
+//  is a simple form of value numbering. We visit only pure arithmetic terms
+//  and tests, so we never visit a type term, which might be circular.
+
+bool isSameTerm(refObject left, refObject right)
+{ if (isEqual(left, right))
+  { return true; }
+  else if (left == nil || right == nil)
+       { return false; }
+       else if (isPair(left) && isPair(right) && car(left) == car(right))
+            { switch (toHook(car(left)))
+              { case andHook:
+                case charEqHook:
+                case charGeHook:
+                case charGtHook:
+                case charLeHook:
+                case charLtHook:
+                case charNeHook:
+                case intAddHook:
+                case intAndHook:
+                case intEqHook:
+                case intGeHook:
+                case intGtHook:
+                case intLeHook:
+                case intLshHook:
+                case intLtHook:
+                case intMulHook:
+                case intNeHook:
+                case intNegHook:
+                case intNotHook:
+                case intOrHook:
+                case intRshHook:
+                case intSubHook:
+                case intXorHook:
+                case notHook:
+                case orHook:
+                case rowAddHook:
+                case rowEqHook:
+                case rowNeHook:
+                case rowSubHook:
+                { left = cdr(left);
+                  right = cdr(right);
+                  while (left != nil && right != nil)
+                  { if (isSameTerm(car(left), car(right)))
+                    { left = cdr(left);
+                      right = cdr(right); }
+                    else
+                    { return false; }}
+                  return left == nil && right == nil; }
+                default:
+                { return false; }}}
+            else
+            { return false; }}
+
+//  OPTIMIZE. Simplify the equates of the transformed PROG term TERM, including
+//  the bodies of its PROCs. Subterms are changed in place.
+
+void optimize(refObject term)
+{ struct
+  { refFrame  link;
+    int       count;
+    refObject constants;
+    refObject labeler;
+    refObject value; } f;
+
+//  Mutual recursions among local functions.
+
+  auto refObject optimizing(refObject);
+  auto refObject optimizingTest(refObject);
+
+//  IS CHANGED. Test if NAME might be changed, or have its address taken, in
+//  the term TERM. NAME may safely appear as an argument to a hook that only
+//  reads its arguments. We use CHANGER to avoid going through the same pair
+//  twice. We never visit the types or names of equates in a WITH.
+
+  bool isChanged(refObject name, refObject term)
+  { bool found;
+    struct
+    { refFrame  link;
+      int       count;
+      refObject changer; } g;
+
+    auto bool isChanging(refObject);
+
+//  IS READ. Test if TERM is NAME, or if it doesn't change NAME.
+
+    bool isRead(refObject term)
+    { return term == name || ! isChanging(term); }
+
+//  IS READ LIST. Test if every term in the list TERMS doesn't change NAME.
+
+    bool isReadList(refObject terms)
+    { while (terms != nil)
+      { if (isRead(car(terms)))
+        { terms = cdr(terms); }
+        else
+        { return false; }}
+      return true; }
+
+//  IS CHANGING. Test if TERM changes NAME. If we don't know what a hook does,
+//  then NAME must not appear as one of its arguments.
+
+    bool isChanging(refObject term)
+    { if (term == nil || ! isPair(term) || gotKey(toss, toss, g.changer, term))
+      { return false; }
+      else
+      { setKey(g.changer, term, nil, nil);
+        switch (toHook(car(term)))
+        { case andHook:
+          case applyHook:
+          case charEqHook:
+          case charGeHook:
+          case charGtHook:
+          case charLeHook:
+          case charLtHook:
+          case charNeHook:
+          case ifHook:
+          case intAddHook:
+          case intAndHook:
+          case intDivHook:
+          case intEqHook:
+          case intGeHook:
+          case intGtHook:
+          case intLeHook:
+          case intLshHook:
+          case intLtHook:
+          case intModHook:
+          case intMulHook:
+          case intNeHook:
+          case intNegHook:
+          case intNotHook:
+          case intOrHook:
+          case intRshHook:
+          case intSubHook:
+          case intXorHook:
+          case lastHook:
+          case notHook:
+          case orHook:
+          case whileHook:
+          { return ! isReadList(cdr(term)); }
+          case caseHook:
+          { term = cdr(term);
+            if (isRead(car(term)))
+            { term = cdr(term);
+              while (cdr(term) != nil)
+              { term = cdr(term);
+                if (isRead(car(term)))
+                { term = cdr(term); }
+                else
+                { return true; }}
+              return ! isRead(car(term)); }
+            else
+            { return true; }}
+          case charCastHook:
+          case intCastHook:
+          case realCastHook:
+          case rowCastHook:
+          { return ! isRead(caddr(term)); }
+          case closeHook:
+          { return cdr(term) != nil && ! isRead(car(cadddr(term))); }
+          case rowToHook:
+          case varToHook:
+          { return ! isRead(cadr(term)); }
+          case varSetHook:
+          { return cadr(term) == name || ! isReadList(cdr(term)); }
+          case withHook:
+          { term = cddr(term);
+            while (cdr(term) != nil)
+            { term = cddr(term);
+              if (isRead(car(term)))
+              { term = cdr(term); }
+              else
+              { return true; }}
+            return ! isRead(car(term)); }
+          default:
+          { term = cdr(term);
+            while (term != nil)
+            { if (car(term) == name || isChanging(car(term)))
+              { return true; }
+              else
+              { term = cdr(term); }}
+            return false; }}}}
+
+//  Lift the lid and look inside.
+
+    push(g, 1);
+    g.changer = pushLayer(nil, plainInfo);
+    found = isChanging(term);
+    pop();
+    destroyLayer(g.changer);
+    return found; }
+
+//  IS PROPAGABLE. Test if an equate whose type is TYPE and whose value is
+//  VALUE declares a variable that can be replaced by VALUE. Its type must be a
+//  VAR of CHAR or INT, since C promotes these types to INT anyway, and VALUE
+//  must be a constant. REALs might be rounded differently, so we leave them
+//  alone.
+
+  bool isPropagable(refObject type, refObject value)
+  { if (value != nil && isCar(type, varHook))
+    { switch (toHook(car(cadr(type))))
+      { case char0Hook:
+        case char1Hook:
+        { return isCharacter(value); }
+        case int0Hook:
+        case int1Hook:
+        case int2Hook:
+        { return isInteger(value); }
+        default:
+        { return false; }}}
+    else
+    { return false; }}
+
+//  OPTIMIZING AND. Simplify (?and L R).
+
+  refObject optimizingAnd(refObject term)
+  { refObject left = cadr(term);
+    refObject right = caddr(term);
+    if (isIntegerZero(left))
+    { return left; }
+    else if (isIntegerNonzero(left))
+         { return right; }
+         else if (isIntegerOne(right) && isBoolean(left))
+              { return left; }
+              else
+              { return term; }}
+
+//  OPTIMIZING ARITHMETIC. Simplify (?H L R) or (?H L), where H is an INT hook
+//  whose arguments were just simplified. If they're all constants now, maybe
+//  because CONSTANTS replaced names by their values, then we return the value
+//  the same way that TRANSFORM would have. We don't divide by 0, since that's
+//  an error that TRANSFORM already reported.
+
+  refObject optimizingArithmetic(refObject term)
+  { int left;
+    int right;
+    if (! isInteger(cadr(term)))
+    { return term; }
+    else if (cddr(term) == nil)
+         { left = toInteger(cadr(term));
+           switch (toHook(car(term)))
+           { case intNegHook:
+             { return makeInteger(- left); }
+             case intNotHook:
+             { return makeInteger(~ left); }
+             default:
+             { return term; }}}
+         else if (! isInteger(caddr(term)))
+              { return term; }
+              else
+              { left = toInteger(cadr(term));
+                right = toInteger(caddr(term));
+                switch (toHook(car(term)))
+                { case intAddHook:
+                  { return makeInteger(left + right); }
+                  case intAndHook:
+                  { return makeInteger(left & right); }
+                  case intDivHook:
+                  { return right == 0 ? term : makeInteger(left / right); }
+                  case intModHook:
+                  { return right == 0 ? term : makeInteger(left % right); }
+                  case intMulHook:
+                  { return makeInteger(left * right); }
+                  case intOrHook:
+                  { return makeInteger(left | right); }
+                  case intSubHook:
+                  { return makeInteger(left - right); }
+                  case intXorHook:
+                  { return makeInteger(left ^ right); }
+                  default:
+                  { return term; }}}}
+
+//  OPTIMIZING CASE. Simplify (?case S L1 T1 L2 T2 ... Tn). If the selector S
+//  is a constant, and every label has the same tag as S, then we return the
+//  term whose label matches S, or the last term if there isn't one.
+
+  refObject optimizingCase(refObject term)
+  { refObject labels;
+    refObject selector;
+    refObject terms;
+    term = cdr(term);
+    car(term) = optimizing(car(term));
+    selector = car(term);
+    terms = cdr(term);
+    while (cdr(terms) != nil)
+    { terms = cdr(terms);
+      car(terms) = optimizing(car(terms));
+      terms = cdr(terms); }
+    car(terms) = optimizing(car(terms));
+    if (isInteger(selector) || isCharacter(selector))
+    { terms = cdr(term);
+      while (cdr(terms) != nil)
+      { labels = car(terms);
+        while (labels != nil)
+        { if (tag(car(labels)) != tag(selector))
+          { return nil; }
+          else
+          { labels = cdr(labels); }}
+        terms = cddr(terms); }
+      terms = cdr(term);
+      while (cdr(terms) != nil)
+      { labels = car(terms);
+        while (labels != nil)
+        { if (isEqual(car(labels), selector))
+          { return cadr(terms); }
+          else
+          { labels = cdr(labels); }}
+        terms = cddr(terms); }
+      return car(terms); }
+    else
+    { return nil; }}
+
+//  OPTIMIZING COMPARISON. Simplify (?H L R) where H is a comparison hook. If L
+//  and R are both constants then we return 0 or 1. If they always return the
+//  same value, and have no side effects, then we know the answer too.
+
+  refObject optimizingComparison(refObject term)
+  { int comparison;
+    refObject left = cadr(term);
+    refObject right = caddr(term);
+    if (isInteger(left) && isInteger(right))
+    { comparison = toInteger(left) - toInteger(right); }
+    else if (isCharacter(left) && isCharacter(right))
+         { comparison = toCharacter(left) - toCharacter(right); }
+         else if (isSameTerm(left, right) && ! isEffected(left))
+              { comparison = 0; }
+              else
+              { return term; }
+    switch (toHook(car(term)))
+    { case charEqHook:
+      case intEqHook:
+      { return toBool[comparison == 0]; }
+      case charGeHook:
+      case intGeHook:
+      { return toBool[comparison >= 0]; }
+      case charGtHook:
+      case intGtHook:
+      { return toBool[comparison > 0]; }
+      case charLeHook:
+      case intLeHook:
+      { return toBool[comparison <= 0]; }
+      case charLtHook:
+      case intLtHook:
+      { return toBool[comparison < 0]; }
+      case charNeHook:
+      case intNeHook:
+      { return toBool[comparison != 0]; }
+      default:
+      { return term; }}}
+
+//  OPTIMIZING IF. Simplify (?if T1 C1 T2 C2 ... Cn). We remove a test and its
+//  clause if the test is 0, or if an earlier test returns the same value. That
+//  earlier test must have failed, but only if no test between them has side
+//  effects, since those might change its value. If a test is a nonzero
+//  constant then its clause becomes the last one. If we have only one clause
+//  left, then we return it. We also simplify (?if T 1 0) to T if T is BOOLEAN,
+//  and (?if T C C) to C if T has no side effects.
+
+  refObject optimizingIf(refObject term)
+  { refObject last;
+    refObject next;
+    bool      repeated;
+    refObject test;
+    refObject tests;
+    last = term;
+    next = cdr(term);
+    while (cdr(next) != nil)
+    { car(next) = optimizingTest(car(next));
+      test = car(next);
+      tests = cdr(term);
+      while (tests != next && ! isSameTerm(car(tests), test))
+      { tests = cddr(tests); }
+      if (tests == next)
+      { repeated = false; }
+      else
+      { tests = cddr(tests);
+        while (tests != next && ! isEffected(car(tests)))
+        { tests = cddr(tests); }
+        repeated = tests == next; }
+      if (isIntegerNonzero(test))
+      { cdr(last) = cdr(next);
+        cdr(cdr(next)) = nil;
+        next = cdr(next);
+        break; }
+      else if (isIntegerZero(test) || (repeated && ! isEffected(test)))
+           { next = cddr(next);
+             cdr(last) = next; }
+           else
+           { car(cdr(next)) = optimizing(cadr(next));
+             last = cdr(next);
+             next = cdr(last); }}
+    car(next) = optimizing(car(next));
+    if (last == term)
+    { return car(next); }
+    else if (cddddr(term) == nil)
+         { test = cadr(term);
+           if (isBoolean(test)
+            && isIntegerOne(caddr(term))
+            && isIntegerZero(cadddr(term)))
+           { return test; }
+           else if (! isEffected(test)
+                 && isSameTerm(caddr(term), cadddr(term)))
+                { return caddr(term); }
+                else
+                { return term; }}
+         else
+         { return term; }}
+
+//  OPTIMIZING TEST. Simplify TERM, whose value is used only to decide whether
+//  it's zero. In these places (?and T 1), (?if T 1 0), and (?not (?not T)) all
+//  mean the same thing as T, even if T isn't a BOOLEAN.
+
+  refObject optimizingTest(refObject term)
+  { term = optimizing(term);
+    while (term != nil && isPair(term))
+    { if (isCar(term, andHook) && isIntegerOne(caddr(term)))
+      { term = cadr(term); }
+      else if (isCar(term, ifHook)
+            && cdddr(term) != nil
+            && cddddr(term) == nil
+            && isIntegerNonzero(caddr(term))
+            && isIntegerZero(cadddr(term)))
+           { term = cadr(term); }
+           else if (isCar(term, notHook) && isCar(cadr(term), notHook))
+                { term = cadr(cadr(term)); }
+                else
+                { break; }}
+    return term; }
+
+//  OPTIMIZING WITH. Simplify (?with F T1 N1 V1 T2 N2 V2 ... B). If an equate
+//  declares a variable that's never changed, and whose value is a constant,
+//  then we remove the equate, and bind its name in CONSTANTS so the constant
+//  will be used in its place. We do this before we visit any values, since a
+//  PROC in an earlier equate might use a later variable. If no equates are
+//  left then we return B.
+
+  refObject optimizingWith(refObject term)
+  { refObject last;
+    refObject next;
+    f.constants = pushLayer(f.constants, plainInfo);
+    last = cdr(term);
+    next = cdr(last);
+    while (cdr(next) != nil)
+    { if (isPropagable(car(next), caddr(next))
+       && ! isChanged(cadr(next), term))
+      { setKey(f.constants, cadr(next), nil, caddr(next));
+        next = cdddr(next);
+        cdr(last) = next; }
+      else
+      { last = cddr(next);
+        next = cdr(last); }}
+    next = cddr(term);
+    while (cdr(next) != nil)
+    { next = cddr(next);
+      car(next) = optimizing(car(next));
+      next = cdr(next); }
+    car(next) = optimizing(car(next));
+    f.constants = destroyLayer(f.constants);
+    if (cadr(term) == nil && cddr(term) == next)
+    { return car(next); }
+    else
+    { return term; }}
+
+//  OPTIMIZING PAIR. Simplify TERM, which is a pair. We must never visit a type
+//  term, since it might be circular, and it might contain slot names that look
+//  like the names of variables.
+
+  refObject optimizingPair(refObject term)
+  { refObject temp;
+    switch (toHook(car(term)))
+    { case andHook:
+      { car(cdr(term)) = optimizingTest(cadr(term));
+        car(cddr(term)) = optimizing(caddr(term));
+        return optimizingAnd(term); }
+      case atHook:
+      { car(cddr(term)) = optimizing(caddr(term));
+        return term; }
+      case caseHook:
+      { temp = optimizingCase(term);
+        return temp == nil ? term : temp; }
+      case charEqHook:
+      case charGeHook:
+      case charGtHook:
+      case charLeHook:
+      case charLtHook:
+      case charNeHook:
+      case intEqHook:
+      case intGeHook:
+      case intGtHook:
+      case intLeHook:
+      case intLtHook:
+      case intNeHook:
+      { car(cdr(term)) = optimizing(cadr(term));
+        car(cddr(term)) = optimizing(caddr(term));
+        return optimizingComparison(term); }
+      case charCastHook:
+      case intCastHook:
+      case realCastHook:
+      case rowCastHook:
+      { car(cddr(term)) = optimizing(caddr(term));
+        return term; }
+      case closeHook:
+      { if (cdr(term) != nil)
+        { temp = cadddr(term);
+          car(temp) = optimizing(car(temp)); }
+        return term; }
+      case ifHook:
+      { return optimizingIf(term); }
+      case intAddHook:
+      case intAndHook:
+      case intDivHook:
+      case intModHook:
+      case intMulHook:
+      case intNegHook:
+      case intNotHook:
+      case intOrHook:
+      case intSubHook:
+      case intXorHook:
+      { temp = cdr(term);
+        while (temp != nil)
+        { car(temp) = optimizing(car(temp));
+          temp = cdr(temp); }
+        return optimizingArithmetic(term); }
+      case notHook:
+      { car(cdr(term)) = optimizingTest(cadr(term));
+        temp = cadr(term);
+        if (isInteger(temp))
+        { return toBool[toInteger(temp) == 0]; }
+        else
+        { return term; }}
+      case orHook:
+      { car(cdr(term)) = optimizing(cadr(term));
+        car(cddr(term)) = optimizing(caddr(term));
+        temp = cadr(term);
+        if (isIntegerNonzero(temp))
+        { return temp; }
+        else if (isIntegerZero(temp))
+             { return caddr(term); }
+             else
+             { return term; }}
+      case rowToHook:
+      case varToHook:
+      { car(cdr(term)) = optimizing(cadr(term));
+        return term; }
+      case slotHook:
+      { return term; }
+      case whileHook:
+      { car(cdr(term)) = optimizingTest(cadr(term));
+        car(cddr(term)) = optimizing(caddr(term));
+        if (isIntegerZero(cadr(term)))
+        { return skip; }
+        else
+        { return term; }}
+      case withHook:
+      { return optimizingWith(term); }
+      default:
+      { temp = cdr(term);
+        while (temp != nil)
+        { car(temp) = optimizing(car(temp));
+          temp = cdr(temp); }
+        return term; }}}
+
+//  OPTIMIZING. Simplify TERM, and return a term that means the same thing. A
+//  name bound in CONSTANTS is replaced by its constant value. LABELER binds
+//  the pairs we've visited to the terms that replace them, so we never go
+//  through the same pair twice.
+
+  refObject optimizing(refObject term)
+  { if (term == nil)
+    { return nil; }
+    else if (isName(term))
+         { if (gotKey(toss, r(f.value), f.constants, term))
+           { return f.value; }
+           else
+           { return term; }}
+         else if (! isPair(term))
+              { return term; }
+              else if (gotKey(toss, r(f.value), f.labeler, term))
+                   { return f.value; }
+                   else
+                   { setKey(f.labeler, term, nil, term);
+                     f.value = optimizingPair(term);
+                     setKey(f.labeler, term, nil, f.value);
+                     return f.value; }}
+
+//  Visit the equates of the PROG term TERM. We optimize the body of each PROC,
+//  and the value of each variable.
+
+  push(f, 3);
+  f.labeler = pushLayer(nil, plainInfo);
+  term = cddr(term);
+  while (term != nil && cdr(term) != nil)
+  { if (car(cddr(term)) != nil)
+    { car(cddr(term)) = optimizing(car(cddr(term))); }
+    term = cdddr(term); }
+  pop();
+  destroyLayer(f.labeler); }
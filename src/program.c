@@ -19,6 +19,130 @@
 
 #include "global.h"
 
+//  DEFER DEFINITIONS. Write C code that defines the PROCs in a list of equates
+//  TERMS, from a PROG term, to DEFERRED instead of TARGET. EMIT DEFINITIONS
+//  will copy only reached PROCs to TARGET later. A PROC is reached if its name
+//  is in the initializer of a variable, or in the body of another reached
+//  PROC. PROCs that aren't reached are never called, so GCC never needs to see
+//  them.
+//
+//  We must write the C code now, rather than later, because how we write it
+//  may depend on what's bound in LAYERS when the PROG is transformed. Each
+//  name is bound in DEFINITIONS to the offset in DEFERRED where its C code
+//  ends. If its PROC is not reached yet, then the binder's INFO slot is the
+//  PROC's closure, otherwise it's NIL.
+//
+//  A PROC can also be called from C code inside a string, so every PROC whose
+//  name appears in such a string is reached too.
+
+void deferDefinitions(refObject terms)
+{ refBuffer oldTarget;
+  struct
+  { refFrame  link;
+    int       count;
+    refObject labeler;
+    refObject pending;
+    refObject temp;
+    refObject type;
+    refObject value; } f;
+
+//  REACHING NAME. If NAME is bound to an unreached PROC, then it's reached,
+//  and we add its closure to PENDING.
+
+  void reachingName(refObject name)
+  { if (gotKey(r(f.type), r(f.value), definitions, name) && f.type != nil)
+    { f.pending = makePair(f.type, f.pending);
+      setKey(definitions, name, nil, f.value); }}
+
+//  REACHING STRING. Visit each deferred PROC whose clean name is a substring
+//  of the C code in STRING.
+
+  void reachingString(refString string)
+  { char buffer[bytes(string) + 1];
+    stringToBuffer(buffer, string);
+    f.temp = firstDefinition;
+    while (f.temp != nil)
+    { if (number(toRefName(car(f.temp))) == 0
+       && strstr(buffer, nameTo(car(f.temp))) != nil)
+      { reachingName(car(f.temp)); }
+      f.temp = cdr(f.temp); }}
+
+//  REACHING. Traverse TERM, visiting the names in it. We use LABELER to avoid
+//  going through the same pair twice, since list structures may be circular.
+
+  void reaching(refObject term)
+  { while (term != nil)
+    { if (isName(term))
+      { reachingName(term);
+        return; }
+      else if (isPair(term) && ! gotKey(toss, toss, f.labeler, term))
+           { setKey(f.labeler, term, nil, nil);
+             if (isCar(term, strApplyHook)
+              || isCar(term, strExceptHook)
+              || isCar(term, strValueHook))
+             { reachingString(toRefString(cadr(term))); }
+             reaching(car(term));
+             term = cdr(term); }
+           else
+           { return; }}}
+
+//  Write the definition of each PROC in TERMS to DEFERRED, and add its name to
+//  the queue.
+
+  push(f, 5);
+  oldTarget = target;
+  target = deferred;
+  f.temp = terms;
+  while (f.temp != nil && cdr(f.temp) != nil)
+  { f.type  = car(f.temp);  f.temp = cdr(f.temp);
+    f.value = cadr(f.temp);
+    if (f.value != nil && isProcEquate(f.type, f.value))
+    { emitFunctionDefinition(car(f.temp), f.value);
+      writeBuffer(deferred);
+      enqueue(r(firstDefinition), r(lastDefinition), car(f.temp));
+      f.type = makeInteger(ftell(stream(deferred)));
+      setKey(definitions, car(f.temp), f.value, f.type); }
+    f.temp = cddr(f.temp); }
+  target = oldTarget;
+
+//  Visit the initializers in TERMS, then visit the bodies of all PROCs reached
+//  from them. No PROC can be reached twice.
+
+  f.labeler = pushLayer(nil, plainInfo);
+  while (terms != nil && cdr(terms) != nil)
+  { f.type  = car(terms);
+    f.value = caddr(terms);
+    if (f.value != nil && ! isProcEquate(f.type, f.value))
+    { reaching(f.value); }
+    terms = cdddr(terms); }
+  while (f.pending != nil)
+  { f.value = car(f.pending);
+    f.pending = cdr(f.pending);
+    reaching(caaddr(cdr(f.value))); }
+  pop();
+  destroyLayer(f.labeler); }
+
+//  EMIT DEFINITIONS. Copy the C code for reached PROCs from DEFERRED to
+//  TARGET, in the order that DEFER DEFINITIONS wrote it.
+
+void emitDefinitions()
+{ int end;
+  refObject info;
+  refObject name;
+  int start;
+  refObject value;
+  if (fclose(stream(deferred)) != 0)
+  { fail("Cannot close a stream to memory."); }
+  start = 0;
+  while (firstDefinition != nil)
+  { name = dequeue(r(firstDefinition), r(lastDefinition));
+    gotKey(r(info), r(value), definitions, name);
+    end = toInteger(value);
+    if (info == nil)
+    { fwrite(deferredText + start, 1, end - start, stream(target)); }
+    start = end; }
+  free(deferredText); }
+
 //  EMIT MAIN. Write the definition of the MAIN function.
 
 void emitMain()
@@ -27,6 +151,10 @@ void emitMain()
   int count;
   refObject name;
 
+//  Write the definitions of the PROCs that were reached.
+
+  emitDefinitions();
+
 //  Write "int main(int N1, char **N2) {", where N1 and N2 appear nowhere else.
 
   writeFormat(target, "int");
@@ -76,6 +204,19 @@ void emitMain()
     writeDirtyName(target, "argv", argvCount);
     writeChar(target, ';'); }
 
+//  If THREADING is declared in the prelude, and we're THREADING, then write C
+//  code that sets THREADING to TRUE. Otherwise it stays FALSE, since it's a C
+//  global variable that isn't initialized.
+
+  name = internSecretName("Threading");
+  if (threading && gotKey(toss, toss, layers, name))
+  { writeName(target, name);
+    writeBlank(target);
+    writeChar(target, '=');
+    writeBlank(target);
+    writeChar(target, '1');
+    writeChar(target, ';'); }
+
 //  Write calls to the initialization functions. There are INIT COUNT of them.
 
   for (count = 1; count <= initCount; count += 1)
@@ -118,7 +259,8 @@ void emitSizes(refSize subtree)
       writeChar(target, ';'); }
     subtree = right(subtree); }}
 
-//  EMIT PROGRAM. Write C code that executes the program TERM.
+//  EMIT PROGRAM. Write C code that executes the program TERM. The definitions
+//  of its PROCs are deferred until we know which ones are reached.
 
 void emitProgram(refObject term)
 { refObject frame;
@@ -127,8 +269,8 @@ void emitProgram(refObject term)
   term = cdr(term);
   emitSizes(right(sizes));
   if (frame == nil)
-  { emitVariableDeclarations(term);
-    emitFunctionDefinitions(false, term);
+  { emitVariableDeclarations(frame, term);
+    emitFunctionDeclarations(false, term);
     if (hasVariables(term))
     { emitInitializerDeclaration();
       writeChar(target, '{');
@@ -136,12 +278,13 @@ void emitProgram(refObject term)
       writeChar(target, '}'); }}
   else
   { emitFrameDeclaration(frame, term);
-    emitVariableDeclarations(term);
-    emitFunctionDefinitions(false, term);
+    emitVariableDeclarations(frame, term);
+    emitFunctionDeclarations(false, term);
     emitInitializerDeclaration();
     writeChar(target, '{');
-    emitFramePush(frame, frameLength(term));
+    emitFramePush(frame);
     emitFrameInitialization(frame, term);
     emitVariableDefinitions(frame, term);
     writeChar(target, '}'); }
-  writeBuffer(target); }
+  writeBuffer(target);
+  deferDefinitions(term); }
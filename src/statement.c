@@ -88,7 +88,7 @@ void emitStatement(refObject term, set wraps)
         while (true)
         { writeFormat(target, "if");
           writeChar(target, '(');
-          emitExpression(car(term), 13);
+          emitIfTest(term);
           writeChar(target, ')');
           term = cdr(term);
           subterm = car(term);
@@ -155,7 +155,7 @@ void emitStatement(refObject term, set wraps)
         frame = car(term);
         term = cdr(term);
         if (frame == nil)
-        { emitVariableDeclarations(term);
+        { emitVariableDeclarations(frame, term);
           emitFunctionDefinitions(true, term);
           emitVariableDefinitions(nil, term);
           term = car(lastPair(term));
@@ -163,9 +163,9 @@ void emitStatement(refObject term, set wraps)
           { emitStatement(term, withSet); }}
         else
         { emitFrameDeclaration(frame, term);
-          emitVariableDeclarations(term);
+          emitVariableDeclarations(frame, term);
           emitFunctionDefinitions(true, term);
-          emitFramePush(frame, frameLength(term));
+          emitFramePush(frame);
           emitFrameInitialization(frame, term);
           emitVariableDefinitions(frame, term);
           term = car(lastPair(term));
@@ -19,85 +19,103 @@
 
 #include "global.h"
 
+//  Orson strings never change once they're made, so STRINGs may share SNIPs. A
+//  SNIP's COUNT says how many of its bytes have been written by any STRING. If
+//  no bytes have been written past the end of a STRING's LAST snip, then a new
+//  STRING that starts with the old one can share its chain, and write its own
+//  bytes after it. We make strings a char at a time this way without copying
+//  them. A SNIP's CHARS says how many chars start in it, so we can find a char
+//  at an index by skipping whole SNIPs, and decoding at most one of them.
+
+//  IS START BYTE. Test if BYTE starts a UTF-8 encoded char, or if it continues
+//  one.
+
+#define isStartByte(byte) ((0xC0 & (byte)) != 0x80)
+
 //  BUFFER TO STRING. Copy the C string BUFFER into an Orson string, and return
-//  the Orson string.
+//  the Orson string. No UTF-8 encoded char starts with 0xFE or 0xFF, so these
+//  bytes can't appear in BUFFER. We use MEMCHR to look for them because it's
+//  usually much faster than a loop.
 
 refObject bufferToString(refChar buffer)
 { if (d(buffer))
-  { int bytes = 0;
-    int chars = 0;
-    int lastIndex = 0;
+  { int length = strlen(buffer);
     struct
-    { refFrame  next;
+    { refFrame  link;
       int       count;
-      refSnip   last;
       refString string; } f;
-    push(f, 2);
+    if (memchr(buffer, 0xFE, length) != nil)
+    { fail("Got 0xFE in bufferToString!"); }
+    if (memchr(buffer, 0xFF, length) != nil)
+    { fail("Got 0xFF in bufferToString!"); }
+    push(f, 1);
     f.string = makeString();
-    f.last = first(f.string) = makeSnip();
-    while (d(buffer))
-    { switch (0xFF & d(buffer))
-      { case b10000000 ... b10111111:
-        { break; }
-        case b11111110 ... b11111111:
-        { fail("Got 0x%02X in bufferToString!", 0xFF & d(buffer)); }
-        default:
-        { chars += 1; }}
-      if (lastIndex == maxSnipLength)
-      { lastIndex = 0;
-        f.last = (next(f.last) = makeSnip()); }
-      self(f.last)[lastIndex] = d(buffer);
-      buffer += 1;
-      bytes += 1;
-      lastIndex += 1; }
-    bytes(f.string) = bytes;
-    chars(f.string) = chars;
+    stringAppendBuffer(f.string, buffer, length);
     pop();
     return toRefObject(f.string); }
   else
   { return emptyString; }}
 
+//  STRING APPEND BYTE. Append BYTE to the end of STRING. We assume that nobody
+//  has written bytes past the end of STRING's LAST snip.
+
+void stringAppendByte(refString string, char byte)
+{ refSnip last;
+  stringGrow(string);
+  last = last(string);
+  self(last)[(int) count(last)] = byte;
+  count(last) += 1;
+  bytes(string) += 1;
+  if (isStartByte(byte))
+  { chars(last) += 1;
+    chars(string) += 1; }}
+
+//  STRING APPEND BUFFER. Append the first COUNT bytes of BUFFER to the end of
+//  STRING, filling as much of STRING's LAST snip as we can at a time. Assume
+//  that nobody has written bytes past the end of STRING's LAST snip.
+
+void stringAppendBuffer(refString string, refChar buffer, int count)
+{ int     chars;
+  refSnip last;
+  int     length;
+  while (count > 0)
+  { stringGrow(string);
+    last = last(string);
+    length = min(count, maxSnipLength - count(last));
+    chars = countChars(buffer, length);
+    memcpy(self(last) + count(last), buffer, length);
+    count(last)   += length;
+    chars(last)   += chars;
+    bytes(string) += length;
+    chars(string) += chars;
+    buffer += length;
+    count -= length; }}
+
+//  STRING APPEND BYTES. Append COUNT bytes to the end of STRING, starting with
+//  the byte at INDEX in SNIP, and continuing through SNIP's successors. Make
+//  the same assumption as STRING APPEND BUFFER.
+
+void stringAppendBytes(refString string, refSnip snip, int index, int count)
+{ int length;
+  while (count > 0)
+  { if (index == maxSnipLength)
+    { index = 0;
+      snip = next(snip); }
+    length = min(count, maxSnipLength - index);
+    stringAppendBuffer(string, self(snip) + index, length);
+    index += length;
+    count -= length; }}
+
 //  STRING CHAR. Return the UTF-8 char at an INDEX in an Orson STRING, assuming
 //  that INDEX is in bounds, and STRING is not empty.
 
 int stringChar(refString string, int index)
-{ refSnip snip      = first(string);
-  int     snipIndex = 0;
+{ int     offset    = stringOffset(string, index);
+  refSnip snip      = stringSnip(string, offset);
+  int     snipIndex = offset % maxSnipLength;
   int     word      = 0;
 
-//  Skip the first INDEX UTF-8 chars of STRING.
-
-  while (index > 0)
-  { switch (0xFF & self(snip)[snipIndex])
-    { case b00000000 ... b01111111:
-      { snipIndex += 1;
-        break; }
-      case b10000000 ... b10111111:
-      { fail("Got 0x%02X in stringChar!", 0xFF & self(snip)[snipIndex]); }
-      case b11000000 ... b11011111:
-      { snipIndex += 2;
-        break; }
-      case b11100000 ... b11101111:
-      { snipIndex += 3;
-        break; }
-      case b11110000 ... b11110111:
-      { snipIndex += 4;
-        break; }
-      case b11111000 ... b11111011:
-      { snipIndex += 5;
-        break; }
-      case b11111100 ... b11111101:
-      { snipIndex += 6;
-        break; }
-      default:
-      { fail("Got 0x%02X in stringChar!", 0xFF & self(snip)[snipIndex]); }}
-    index -= 1;
-    if (snipIndex >= maxSnipLength)
-    { snipIndex -= maxSnipLength;
-      snip = next(snip); }}
-
-//  Begin assembling the UTF-32 char that follows the skipped chars. Start with
-//  its first byte.
+//  Begin assembling the UTF-32 char at OFFSET. Start with its first byte.
 
   switch (0xFF & self(snip)[snipIndex])
   { case b00000000 ... b01111111:
@@ -194,126 +212,101 @@ int stringCompare(refString leftString, refString rightString)
   return leftLength - rightLength; }
 
 //  STRING CONCATENATE. Concatenate Orson strings LEFT STRING and RIGHT STRING.
-//  Return the result as a new Orson string. We assume that both strings aren't
-//  empty.
+//  Return the result as a new Orson string. It may share LEFT STRING's SNIPs.
 
 refString stringConcatenate(refString leftString, refString rightString)
-{ int count;
-  int lastIndex;
-  int snipIndex;
-  struct
+{ struct
   { refFrame  link;
     int       count;
-    refSnip   snip;
-    refSnip   last;
     refString string; } f;
-  push(f, 3);
+  push(f, 1);
+  f.string = stringExtend(leftString);
+  stringAppendBytes(f.string, first(rightString), 0, bytes(rightString));
+  pop();
+  return f.string; }
 
-//  Make the new STRING, and its LAST snip. We know how many bytes and how many
-//  chars it will have.
+//  STRING EXTEND. Return a new Orson string with the same chars as STRING, to
+//  which more bytes will be appended. If no bytes were written past the end of
+//  STRING's LAST snip, then the new string shares STRING's SNIPs. Otherwise it
+//  gets a copy of them. Bytes must be appended to the new string before we're
+//  called again, or two strings might write the same bytes.
 
+refString stringExtend(refString string)
+{ struct
+  { refFrame  link;
+    int       count;
+    refString string; } f;
+  push(f, 1);
   f.string = makeString();
-  f.last = first(f.string) = makeSnip();
-  bytes(f.string) = bytes(leftString) + bytes(rightString);
-  chars(f.string) = chars(leftString) + chars(rightString);
-
-//  Copy LEFT STRING into the new STRING.
-
-  lastIndex = 0;
-  snipIndex = 0;
-  f.snip = first(leftString);
-  count = bytes(leftString);
-  while (count > 0)
-  { if (lastIndex == maxSnipLength)
-    { lastIndex = 0;
-      f.last = (next(f.last) = makeSnip()); }
-    if (snipIndex == maxSnipLength)
-    { snipIndex = 0;
-      f.snip = next(f.snip); }
-    self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-    lastIndex += 1;
-    snipIndex += 1;
-    count -= 1; }
-
-//  Copy RIGHT STRING into the new STRING.
-
-  snipIndex = 0;
-  f.snip = first(rightString);
-  count = bytes(rightString);
-  while (count > 0)
-  { if (lastIndex == maxSnipLength)
-    { lastIndex = 0;
-      f.last = (next(f.last) = makeSnip()); }
-    if (snipIndex == maxSnipLength)
-    { snipIndex = 0;
-      f.snip = next(f.snip); }
-    self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-    lastIndex += 1;
-    snipIndex += 1;
-    count -= 1; }
-
-//  Clean up and return.
-
+  if (bytes(string) > 0)
+  { if (
+     count(last(string)) == (bytes(string) - 1) % maxSnipLength + 1 &&
+     next(last(string)) == nil)
+    { first(f.string) = first(string);
+      last(f.string)  = last(string);
+      bytes(f.string) = bytes(string);
+      chars(f.string) = chars(string); }
+    else
+    { stringAppendBytes(f.string, first(string), 0, bytes(string)); }}
   pop();
   return f.string; }
 
+//  STRING GROW. Make sure that STRING's LAST snip has room for one more byte.
+//  If it doesn't, then add a new SNIP to the end of STRING's chain.
+
+void stringGrow(refString string)
+{ refSnip newSnip;
+  if (last(string) == nil)
+  { newSnip = makeSnip();
+    first(string) = newSnip;
+    last(string) = newSnip; }
+  else if (count(last(string)) == maxSnipLength)
+       { newSnip = makeSnip();
+         next(last(string)) = newSnip;
+         last(string) = newSnip; }}
+
+//  STRING OFFSET. Return the offset of the first byte of the char at INDEX in
+//  an Orson STRING, assuming that INDEX is in bounds. If all of STRING's chars
+//  have one byte, then that's just INDEX. Otherwise we skip SNIPs in which the
+//  char can't start, then look for it in the SNIP where it does.
+
+int stringOffset(refString string, int index)
+{ int     offset;
+  refSnip snip;
+  int     snipIndex;
+  if (bytes(string) == chars(string))
+  { return index; }
+  else if (index == chars(string))
+       { return bytes(string); }
+       else
+       { offset = 0;
+         snip = first(string);
+         while (index >= chars(snip))
+         { index -= chars(snip);
+           offset += maxSnipLength;
+           snip = next(snip); }
+         snipIndex = 0;
+         while (! isStartByte(self(snip)[snipIndex]) || index > 0)
+         { if (isStartByte(self(snip)[snipIndex]))
+           { index -= 1; }
+           snipIndex += 1; }
+         return offset + snipIndex; }}
+
 //  STRING POSTFIX. Append a UTF-32 char WORD to the end of an Orson STRING.
+//  The result may share STRING's SNIPs.
 
 refString stringPostfix(refString string, int word)
 { refChar bytes;
-  int     count;
-  int     lastIndex;
-  int     snipIndex;
   struct
   { refFrame  link;
     int       count;
-    refSnip   last;
-    refSnip   snip;
     refString string; } f;
-  push(f, 3);
-
-//  Make the new STRING and its LAST snip. We know how many chars it will have,
-//  but not (yet) how many bytes.
-
-  f.string = makeString();
-  f.last = first(f.string) = makeSnip();
-  chars(f.string) = chars(string) + 1;
-
-//  Copy the old STRING into the new STRING.
-
-  lastIndex = 0;
-  snipIndex = 0;
-  f.snip = first(string);
-  count = bytes(string);
-  while (count > 0)
-  { if (lastIndex == maxSnipLength)
-    { lastIndex = 0;
-      f.last = (next(f.last) = makeSnip()); }
-    if (snipIndex == maxSnipLength)
-    { snipIndex = 0;
-      f.snip = next(f.snip); }
-    self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-    lastIndex += 1;
-    snipIndex += 1;
-    count -= 1; }
-
-//  Encode WORD as a series of BYTES and copy them into the new STRING. We keep
-//  track of the number of bytes copied in COUNT.
-
-  count = 0;
+  push(f, 1);
+  f.string = stringExtend(string);
   bytes = encodeChar(word);
   while (d(bytes) != eosChar)
-  { if (lastIndex == maxSnipLength)
-    { lastIndex = 0;
-      f.last = (next(f.last) = makeSnip()); }
-    self(f.last)[lastIndex] = d(bytes);
-    lastIndex += 1;
-    bytes += 1;
-    count += 1; }
-
-//  Update the new string's BYTES count, clean up, and return.
-
-  bytes(f.string) = bytes(string) + count;
+  { stringAppendByte(f.string, d(bytes));
+    bytes += 1; }
   pop();
   return f.string; }
 
@@ -321,217 +314,74 @@ refString stringPostfix(refString string, int word)
 
 refString stringPrefix(int word, refString string)
 { refChar bytes;
-  int     count;
-  int     lastIndex;
-  int     snipIndex;
   struct
   { refFrame  link;
     int       count;
-    refSnip   last;
-    refSnip   snip;
     refString string; } f;
-  push(f, 3);
-
-//  Make the new STRING and its LAST snip. We know how many chars it will have,
-//  but not (yet) how many bytes.
-
+  push(f, 1);
   f.string = makeString();
-  f.last = first(f.string) = makeSnip();
-  chars(f.string) = chars(string) + 1;
-
-//  Encode WORD as a series of BYTES and copy them into the new STRING. We keep
-//  track of the number of bytes copied in COUNT. When we're done copying, LAST
-//  INDEX is the number of bytes in BYTES, so we'll know the number of bytes in
-//  the new STRING.
-
-  lastIndex = 0;
   bytes = encodeChar(word);
   while (d(bytes) != eosChar)
-  { if (lastIndex == maxSnipLength)
-    { lastIndex = 0;
-      f.last = (next(f.last) = makeSnip()); }
-    self(f.last)[lastIndex] = d(bytes);
-    lastIndex += 1;
+  { stringAppendByte(f.string, d(bytes));
     bytes += 1; }
-  bytes(f.string) = bytes(string) + lastIndex;
+  stringAppendBytes(f.string, first(string), 0, bytes(string));
+  pop();
+  return f.string; }
 
-//  Copy the old STRING into the new STRING.
+//  STRING SNIP. Return the SNIP in an Orson STRING that holds the byte whose
+//  offset is OFFSET, assuming that OFFSET is in bounds.
 
-  snipIndex = 0;
-  f.snip = first(string);
-  count = bytes(string);
-  while (count > 0)
-  { if (lastIndex == maxSnipLength)
-    { lastIndex = 0;
-      f.last = (next(f.last) = makeSnip()); }
-    if (snipIndex == maxSnipLength)
-    { snipIndex = 0;
-      f.snip = next(f.snip); }
-    self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-    lastIndex += 1;
-    snipIndex += 1;
-    count -= 1; }
-
-//  Clean up and return.
+refSnip stringSnip(refString string, int offset)
+{ refSnip snip = first(string);
+  while (offset >= maxSnipLength)
+  { offset -= maxSnipLength;
+    snip = next(snip); }
+  return snip; }
 
-  pop();
-  return f.string; }
+//  STRING TO BUFFER. Copy an Orson STRING into the C string BUFFER, and add an
+//  EOS CHAR at the end. We assume BUFFER will be long enough.
+
+void stringToBuffer(refChar buffer, refString string)
+{ int     count = bytes(string);
+  refSnip snip  = first(string);
+  while (count > maxSnipLength)
+  { memcpy(buffer, self(snip), maxSnipLength);
+    buffer += maxSnipLength;
+    count -= maxSnipLength;
+    snip = next(snip); }
+  if (count > 0)
+  { memcpy(buffer, self(snip), count);
+    buffer += count; }
+  d(buffer) = eosChar; }
 
 //  SUBSTRING. Return a substring of an Orson STRING that contains chars having
-//  indexes less than or equal to START and strictly less than END. Assume that
-//  START and END are in bounds, and that END is greater than START.
+//  indexes greater than or equal to START and strictly less than END. Assume
+//  that START and END are in bounds, and that END is not less than START. If
+//  START is 0, then the substring shares STRING's SNIPs. Otherwise we copy its
+//  bytes.
 
 refString substring(refString string, int start, int end)
-{ int count;
-  int lastIndex;
-  int range;
-  int snipIndex;
+{ int endOffset;
+  int startOffset;
   struct
   { refFrame  link;
     int       count;
-    refSnip   last;
-    refSnip   snip;
     refString string; } f;
-  push(f, 3);
-
-//  Make the new STRING and its LAST snip. We know how many chars it will have,
-//  but not yet how many bytes.
-
+  push(f, 1);
   f.string = makeString();
-  f.last = first(f.string) = makeSnip();
-  range = chars(f.string) = end - start;
-
-//  Skip the first START chars in STRING.
-
-  snipIndex = 0;
-  f.snip = first(string);
-  while (start > 0)
-  { start -= 1;
-    switch (0xFF & self(f.snip)[snipIndex])
-    { case b00000000 ... b01111111:
-      { snipIndex += 1;
-        break; }
-      case b10000000 ... b10111111:
-      { fail("Got 0x%2X in substring!", 0xFF & self(f.snip)[snipIndex]); }
-      case b11000000 ... b11011111:
-      { snipIndex += 2;
-        break; }
-      case b11100000 ... b11101111:
-      { snipIndex += 3;
-        break; }
-      case b11110000 ... b11110111:
-      { snipIndex += 4;
-        break; }
-      case b11111000 ... b11111011:
-      { snipIndex += 5;
-        break; }
-      case b11111100 ... b11111101:
-      { snipIndex += 6;
-        break; }
-      default:
-      { fail("Got 0x%2X in substring!", 0xFF & self(f.snip)[snipIndex]); }}
-    if (snipIndex >= maxSnipLength)
-    { snipIndex -= maxSnipLength;
-      f.snip = next(f.snip); }}
-
-//  Copy RANGE chars from the old STRING into the new STRING. Every SWITCH case
-//  but the last falls through to the next one. COUNT keeps track of the number
-//  of bytes we've copied.
-
-  count = 0;
-  lastIndex = 0;
-  while (range > 0)
-  { range -= 1;
-    switch (0xFF & self(f.snip)[snipIndex])
-    { case b11111100 ... b11111101:
-      { count += 1;
-        if (lastIndex == maxSnipLength)
-        { lastIndex = 0;
-          f.last = (next(f.last) = makeSnip()); }
-        if (snipIndex == maxSnipLength)
-        { snipIndex = 0;
-          f.snip = next(f.snip); }
-        self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-        lastIndex += 1;
-        snipIndex += 1; }
-      case b11111000 ... b11111011:
-      { count += 1;
-        if (lastIndex == maxSnipLength)
-        { lastIndex = 0;
-          f.last = (next(f.last) = makeSnip()); }
-        if (snipIndex == maxSnipLength)
-        { snipIndex = 0;
-          f.snip = next(f.snip); }
-        self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-        lastIndex += 1;
-        snipIndex += 1; }
-      case b11110000 ... b11110111:
-      { count += 1;
-        if (lastIndex == maxSnipLength)
-        { lastIndex = 0;
-          f.last = (next(f.last) = makeSnip()); }
-        if (snipIndex == maxSnipLength)
-        { snipIndex = 0;
-          f.snip = next(f.snip); }
-        self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-        lastIndex += 1;
-        snipIndex += 1; }
-      case b11100000 ... b11101111:
-      { count += 1;
-        if (lastIndex == maxSnipLength)
-        { lastIndex = 0;
-          f.last = (next(f.last) = makeSnip()); }
-        if (snipIndex == maxSnipLength)
-        { snipIndex = 0;
-          f.snip = next(f.snip); }
-        self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-        lastIndex += 1;
-        snipIndex += 1; }
-      case b11000000 ... b11011111:
-      { count += 1;
-        if (lastIndex == maxSnipLength)
-        { lastIndex = 0;
-          f.last = (next(f.last) = makeSnip()); }
-        if (snipIndex == maxSnipLength)
-        { snipIndex = 0;
-          f.snip = next(f.snip); }
-        self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-        lastIndex += 1;
-        snipIndex += 1; }
-      case b00000000 ... b01111111:
-      { count += 1;
-        if (lastIndex == maxSnipLength)
-        { lastIndex = 0;
-          f.last = (next(f.last) = makeSnip()); }
-        if (snipIndex == maxSnipLength)
-        { snipIndex = 0;
-          f.snip = next(f.snip); }
-        self(f.last)[lastIndex] = self(f.snip)[snipIndex];
-        lastIndex += 1;
-        snipIndex += 1;
-        break; }
-      default:
-      { fail("Got 0x%02X in substring!", 0xFF & self(f.snip)[snipIndex]); }}}
-
-//  Update the BYTES count of the new STRING, clean up, and return.
-
-  bytes(f.string) = count;
+  if (start < end)
+  { endOffset = stringOffset(string, end);
+    if (start == 0)
+    { first(f.string) = first(string);
+      last(f.string)  = stringSnip(string, endOffset - 1);
+      bytes(f.string) = endOffset;
+      chars(f.string) = end; }
+    else
+    { startOffset = stringOffset(string, start);
+      stringAppendBytes(
+       f.string,
+       stringSnip(string, startOffset),
+       startOffset % maxSnipLength,
+       endOffset - startOffset); }}
   pop();
   return f.string; }
-
-//  STRING TO BUFFER. Copy an Orson STRING into the C string BUFFER, and add an
-//  EOS CHAR at the end. We assume BUFFER will be long enough.
-
-void stringToBuffer(refChar buffer, refString string)
-{ int count = bytes(string);
-  int snipIndex = 0;
-  refSnip snip = first(string);
-  while (count > 0)
-  { if (snipIndex == maxSnipLength)
-    { snipIndex = 0;
-      snip = next(snip); }
-    d(buffer) = self(snip)[snipIndex];
-    buffer += 1;
-    snipIndex += 1;
-    count -= 1; }
-  d(buffer) = eosChar; }
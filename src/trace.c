@@ -0,0 +1,263 @@
+//
+//  ORSON/TRACE. Profile the hooks and forms called by TRANSFORM.
+//
+//  Copyright (C) 2012 James B. Moen.
+//
+//  This program  is free  software: you can  redistribute it and/or  modify it
+//  under the terms of the  GNU General Public License as published by the Free
+//  Software Foundation, either  version 3 of the License,  or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY  WARRANTY; without  even  the implied  warranty  of MERCHANTABILITY  or
+//  FITNESS FOR A  PARTICULAR PURPOSE.  See the GNU  General Public License for
+//  more details.
+//
+//  You should  have received a  copy of the  GNU General Public  License along
+//  with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "global.h"
+
+//  If the -f option is given, then TRANSFORM records each hook it calls, and
+//  APPLY HOOK records each form it applies, in a tree of TRACEs. Each path
+//  from the root of the tree is a stack of calls, so a hook or form has a
+//  TRACE for every stack it was called from. There may be millions of calls,
+//  so we time them with a monotonic clock, which is much cheaper to read than
+//  a processor time clock. After translation, WRITE TRACES writes the stacks
+//  so that flame graph tools can read them, and writes a table of what each
+//  hook or form cost in all its stacks.
+
+//  INIT TRACE. Initialize globals. The root of TRACES is never called.
+
+void initTrace()
+{ traces    = makeTrace(0, nil, nil);
+  lastTrace = traces; }
+
+//  TRACE TIME. Return a time in seconds from a clock that never goes backward.
+
+double traceTime()
+{ struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, r(time));
+  return time.tv_sec + time.tv_nsec / 1.0e9; }
+
+//  START TRACE. Start a call to the hook or form whose key is KEY, and whose
+//  name is STRING. Find the child of LAST TRACE that has KEY, making it if it
+//  doesn't exist, and make it LAST TRACE. The same calls tend to be made over
+//  and over, so we move the child to the front of its siblings.
+
+void startTrace(int key, refChar string)
+{ refTrace left = nil;
+  refTrace right = child(lastTrace);
+  while (right != nil && key(right) != key)
+  { left = right;
+    right = next(right); }
+  if (right == nil)
+  { right = makeTrace(key, string, lastTrace);
+    child(lastTrace) = right; }
+  else if (left != nil)
+       { next(left) = next(right);
+         next(right) = child(lastTrace);
+         child(lastTrace) = right; }
+  calls(right) += 1;
+  children(right) = 0.0;
+  start(right) = traceTime();
+  lastTrace = right; }
+
+//  START TRACE FORM. Start a call to a form member whose BODY is transformed
+//  by APPLY HOOK. The form is known by the char count where BODY starts, and
+//  it's named by METHOD if METHOD is a NAME. If we don't know where BODY
+//  starts, we pretend it's at char count 0, which can't be in any source file.
+
+void startTraceForm(refObject method, refObject body)
+{ int count;
+  if (isPair(body) && ! isTriple(body) && info(body) >= 0)
+  { count = info(body); }
+  else
+  { count = 0; }
+  startTrace(-1 - count, (isName(method) ? nameTo(method) : nil)); }
+
+//  STOP TRACE. Stop the call in progress whose TRACE is LAST TRACE, and charge
+//  its time to it. Its parent becomes LAST TRACE again, and the time is
+//  charged to the parent's children too.
+
+void stopTrace()
+{ double duration = traceTime() - start(lastTrace);
+  inclusive(lastTrace) += duration;
+  exclusive(lastTrace) += duration - children(lastTrace);
+  lastTrace = parent(lastTrace);
+  children(lastTrace) += duration; }
+
+//  WRITE TRACES. Write a line to the file TRACE PATH for each stack of calls
+//  in TRACES. It has the names of the calls in the stack, outermost first,
+//  joined by semicolons, then a blank, then how many microseconds were spent
+//  in the innermost call but not in its children. Then write a table to DEBUG
+//  with a row for each hook or form, most expensive first, followed by the
+//  totals.
+
+void writeTraces()
+{ long      calls;
+  int       count;
+  double    exclusive;
+  double    inclusive;
+  int       index;
+  int       length;
+  refTrace  next;
+  refTrace  *sorted;
+  refStream stream;
+
+//  IS COSTLIER. Compare the TRACEs that LEFT and RIGHT point to, so that QSORT
+//  will put the one with the most EXCLUSIVE time first.
+
+  int isCostlier(const void *left, const void *right)
+  { double leftTime = exclusive(d((refTrace *) left));
+    double rightTime = exclusive(d((refTrace *) right));
+    return (leftTime < rightTime) - (leftTime > rightTime); }
+
+//  IS LOWER. Compare the TRACEs that LEFT and RIGHT point to, so that QSORT
+//  will put the one with the lower KEY first.
+
+  int isLower(const void *left, const void *right)
+  { int leftKey = key(d((refTrace *) left));
+    int rightKey = key(d((refTrace *) right));
+    return (leftKey > rightKey) - (leftKey < rightKey); }
+
+//  IS OUTERMOST. Test if TRACE's call isn't inside another call to the same
+//  hook or form. If it is, then its INCLUSIVE time was already counted there.
+
+  bool isOutermost(refTrace trace)
+  { refTrace other = parent(trace);
+    while (other != traces && key(other) != key(trace))
+    { other = parent(other); }
+    return other == traces; }
+
+//  COUNT TRACES. Return the number of TRACEs in TRACE and its siblings, and in
+//  all their descendants.
+
+  int countTraces(refTrace trace)
+  { int count = 0;
+    while (trace != nil)
+    { count += 1 + countTraces(child(trace));
+      trace = next(trace); }
+    return count; }
+
+//  COLLECT TRACES. Copy TRACE, its siblings, and all their descendants to
+//  SORTED, starting at INDEX.
+
+  void collectTraces(refTrace trace)
+  { while (trace != nil)
+    { sorted[index] = trace;
+      index += 1;
+      collectTraces(child(trace));
+      trace = next(trace); }}
+
+//  WRITE CLEAN. Write STRING to OUTPUT, with underscores instead of blanks and
+//  semicolons, since those separate counts and calls in a line.
+
+  void writeClean(refStream output, refChar string)
+  { while (d(string) != eosChar)
+    { if (d(string) == ' ' || d(string) == ';')
+      { fputc('_', output); }
+      else
+      { fputc(d(string), output); }
+      string += 1; }}
+
+//  WRITE CALL. Write the name of TRACE's call to OUTPUT. A hook is written
+//  with a question mark in front. A form is written as its name, or as "form"
+//  if it has none, then an at sign, then the name and line of the file where
+//  its body starts.
+
+  void writeCall(refStream output, refTrace trace)
+  { int     line;
+    refChar path;
+    refChar slash;
+    if (key(trace) >= 0)
+    { fputc('?', output);
+      writeClean(output, hookTo(hooks[key(trace)])); }
+    else
+    { writeClean(output, (string(trace) == nil ? "form" : string(trace)));
+      line = findLine(r(path), -1 - key(trace));
+      if (path != nil)
+      { slash = strrchr(path, '/');
+        fputc('@', output);
+        writeClean(output, (slash == nil ? path : slash + 1));
+        fprintf(output, ":%i", line); }}}
+
+//  WRITE STACK. Write the names of the calls in TRACE's stack, outermost
+//  first.
+
+  void writeStack(refTrace trace)
+  { if (parent(trace) != traces)
+    { writeStack(parent(trace));
+      fputc(';', stream); }
+    writeCall(stream, trace); }
+
+//  WRITE STACKS. Write a line for TRACE, its siblings, and all descendants
+//  that spent at least a microsecond in their own calls.
+
+  void writeStacks(refTrace trace)
+  { long micros;
+    while (trace != nil)
+    { micros = (long) (exclusive(trace) * 1.0e6 + 0.5);
+      if (micros > 0)
+      { writeStack(trace);
+        fprintf(stream, " %li\n", micros); }
+      writeStacks(child(trace));
+      trace = next(trace); }}
+
+//  Lost? This is WRITE TRACES's body. Write the stacks.
+
+  stream = fopen(tracePath, "w");
+  if (stream == nil)
+  { fail("Cannot open file '%s'.", tracePath); }
+  writeStacks(child(traces));
+  if (fclose(stream) != 0)
+  { fail("Cannot close file '%s'.", tracePath); }
+
+//  The total INCLUSIVE time is the time spent in the outermost calls. Then
+//  copy all the TRACEs into SORTED, and sort them by KEY. Merge the TRACEs for
+//  each KEY into the first one, so it has the totals for that hook or form. We
+//  can do this destructively, since we're done with the tree.
+
+  inclusive = 0.0;
+  for (next = child(traces); next != nil; next = next(next))
+  { inclusive += inclusive(next); }
+  count = countTraces(child(traces));
+  sorted = malloc(count * sizeof(refTrace) + 1);
+  if (sorted == nil)
+  { fail("Cannot sort traces in writeTraces!"); }
+  index = 0;
+  collectTraces(child(traces));
+  for (index = 0; index < count; index += 1)
+  { if (! isOutermost(sorted[index]))
+    { inclusive(sorted[index]) = 0.0; }}
+  qsort(sorted, count, sizeof(refTrace), isLower);
+  length = 0;
+  for (index = 0; index < count; index += 1)
+  { next = sorted[index];
+    if (length > 0 && key(sorted[length - 1]) == key(next))
+    { calls(sorted[length - 1])     += calls(next);
+      exclusive(sorted[length - 1]) += exclusive(next);
+      inclusive(sorted[length - 1]) += inclusive(next); }
+    else
+    { sorted[length] = next;
+      length += 1; }}
+
+//  Write the merged TRACEs, most expensive first, then the totals.
+
+  qsort(sorted, length, sizeof(refTrace), isCostlier);
+  calls = 0;
+  exclusive = 0.0;
+  fprintf(stream(debug), "%10s %10s %10s  %s\n",
+   "inclusive", "exclusive", "calls", "call");
+  for (index = 0; index < length; index += 1)
+  { next = sorted[index];
+    calls += calls(next);
+    exclusive += exclusive(next);
+    fprintf(stream(debug), "%10.3f %10.3f %10li  ",
+     inclusive(next) * 1000.0, exclusive(next) * 1000.0, calls(next));
+    writeCall(stream(debug), next);
+    fputc(eolChar, stream(debug)); }
+  fprintf(stream(debug), "%10.3f %10.3f %10li  %s\n",
+   inclusive * 1000.0, exclusive * 1000.0, calls, "total");
+  free(sorted); }
@@ -74,6 +74,7 @@ void transform(refRefObject type, refRefObject value, refObject terms)
     { fail("Got ([Nil]) in transform!"); }
     else
     { level += 1;
+      transformCount += 1;
       if (level <= maxDebugLevel)
       { fprintf(stream(debug), "[%i] Transform\n", level);
         writeObject(debug, term); }
@@ -149,6 +150,8 @@ void transform(refRefObject type, refRefObject value, refObject terms)
             { terms = cdr(term);
               if (level < maxDebugLevel)
               { fputc(eolChar, stream(debug)); }
+              if (tracePath != nil)
+              { startTrace(toHook(car(term)), nil); }
               switch (toHook(car(term)))
               {
 
@@ -436,7 +439,11 @@ case applyHook:
           f1.layers = layers;
           layers = f1.layer;
           setCounts(layers, cadr(f0.type), cdr(formCall));
+          if (tracePath != nil)
+          { startTraceForm(car(formCall), f1.body); }
           transform(r(f0.type), r(f0.value), f1.body);
+          if (tracePath != nil)
+          { stopTrace(); }
           if (! isCoerced(r(f0.type), r(f0.value), layers, f1.yield))
           { if (isSubtype(layers, f1.yield, plainLayer, voidSimple))
             { if (isGroundSubtype(f0.type, exeJoker))
@@ -4049,12 +4056,14 @@ case progHook:
 //  Now that NAME is bound, we update forwarded REF and ROW types, just in case
 //  any of them used NAME (correctly or incorrectly) as a base type.
 
-    updatePointers(); }
+    updatePointers(f.name); }
 
 //  We've now transformed all the equates, so we update any PROC closures which
 //  may have been created. Clean up and return.
 
   updateProcedures();
+  destroyLayer(bases);
+  bases = nil;
   pop();
   d(type) = voidSimple;
   d(value) = f.first;
@@ -4530,11 +4539,11 @@ case realSubHook:
   break; }
 
 //  REFER, ROW. Transform a REF or ROW type. If its base type is a unbound name
-//  then link its argument list into a global chain BASES, through an invisible
-//  second argument to the type. We'll substitute a value for that unbound name
-//  later. If its base type is an undeclared name, then it turns into VOID, and
-//  we assert an error. We preserve INFO slots below so we can attribute errors
-//  to their places of origin.
+//  then link its argument list into the chain that BASES binds to that name,
+//  through an invisible second argument to the type. We'll substitute a value
+//  for that name later. If its base type is an undeclared name, then it turns
+//  into VOID, and we assert an error. We preserve INFO slots below so we can
+//  attribute errors to their places of origin.
 
 case referHook:
 case rowHook:
@@ -4553,9 +4562,12 @@ case rowHook:
   if (isName(f.base))
   { if (gotKey(r(f.type), r(f.value), layers, f.base))
     { if (f.type == nil)
-      { f.value = makePaire(bases, nil, info(terms));
+      { if (bases == nil)
+        { bases = pushLayer(nil, plainInfo); }
+        gotKey(toss, r(f.value), bases, f.base);
+        f.value = makePaire(f.value, nil, info(terms));
         f.value = makePaire(f.base, f.value, info(terms));
-        bases = f.value; }
+        setKey(bases, f.base, nil, f.value); }
       else
       { if (! isGroundSubtype(f.type, typeExeJoker))
         { objectError(terms, typeExeErr);
@@ -6419,7 +6431,7 @@ case withHook:
 //  Now that NAME is bound, we update forwarded REF and ROW types, just in case
 //  any of them used NAME (correctly or incorrectly) as a base type.
 
-    updatePointers(); }
+    updatePointers(f.name); }
 
 //  We've now transformed all the equates, so we transform the body to TYPE and
 //  VALUE. If we made no execution equates, then we do not make a WITH: we just
@@ -6473,6 +6485,7 @@ case withHook:
 //  old value of LAYERS. Clean up and return.
 
   updateProcedures();
+  destroyLayer(bases);
   bases = f.bases;
   layers = popLayer(layers);
   firstProc = f.firstProc;
@@ -6489,7 +6502,9 @@ case withHook:
                 { objectError(term, unknownCallErr);
                   d(type) = voidSimple;
                   d(value) = skip;
-                  break; }}}
+                  break; }}
+              if (tracePath != nil)
+              { stopTrace(); }}
 
 //  It's also an error to call an object that's not a hook.
 